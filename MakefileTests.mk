@@ -26,6 +26,15 @@ INCLUDE_DIRS = \
 	$(PROJECT_HOME_DIR)/include \
 
 CPPUTEST_WARNINGFLAGS += -Wall -Werror -Wswitch-default -Wswitch-enum
+# coroutines in IR_Decoder.hpp
+CPPUTEST_CXXFLAGS += -std=c++20
+# optional features covered by the tests
+CPPUTEST_CPPFLAGS += -DIR_DECODER_QUALITY -DIR_DECODER_TRACE -DIR_DECODER_RECORDER
+CPPUTEST_CPPFLAGS += -DIR_DECODER_DURATIONS -DIR_DECODER_DUAL_RING -DIR_DECODER_SAMPLES -DIR_DECODER_CARRIER
 
 
 include $(CPPUTEST_HOME)/build/MakefileWorker.mk
+
+# GCC 12 lowers a coroutine body to a switch over its suspend points without a default label and reports it
+# against the coroutine, so the warning cannot be fixed in the source; the rest of the tree keeps it
+$(CPPUTEST_OBJS_DIR)/tests/IR_DecoderCoroutineTest.o: CXXFLAGS += -Wno-switch-default
@@ -0,0 +1,377 @@
+#include "IR_Decoder.h"
+#include "IR_Generator.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+#define MAX_BUFFER_SIZE 255
+#define MAX_FRAMES      64
+
+// input layout:
+//   [mode] [flags] [bufferSize] [currentIndex] [state] [pulseNumber] [param] then
+//   raw mode:       { [count] [count x uint32 LE] }... one decode per record
+//   generator mode: [seed x4] [jitter] [glitchRate] [dropRate] then one [address] [command] [repeats] per frame
+// raw values are ring captures, 64 bit timestamp steps, widths in us (low half) or sample words by mode;
+// the generator's edges are converted to match, samples are raw only and carrier mode gets demodulated edges
+enum {
+    MODE_RING = 0, // timestamp ring, DMA or sentinel zeros
+    MODE_CARRIER, // timestamp ring of raw carrier edges, carrierGap 1 + param us
+    MODE_DURATION_RING,
+    MODE_DUAL_RING, // edges alternate between the falling and rising rings
+    MODE_TIMESTAMPS, // IR_Decoder_DecodeTimestamps
+    MODE_DURATIONS, // IR_Decoder_DecodeDurations
+    MODE_SAMPLES, // IR_Decoder_DecodeSamples every 100 * (1 + param) ns
+    MODES
+};
+#define FLAG_DMA        0x01 // ring mode, the ring modes needing it always use it
+#define FLAG_GENERATOR  0x02
+#define FLAG_BOUNDED    0x04 // decode rings 1 + param % 4 pulses at a time
+#define HEADER_SIZE     7
+#define IDLE_WIDTH      UINT16_MAX
+
+static uint32_t data[MAX_BUFFER_SIZE];
+static uint32_t risingData[MAX_BUFFER_SIZE];
+static uint16_t durationData[MAX_BUFFER_SIZE];
+static uint8_t dmaIndex;
+static uint8_t risingDmaIndex;
+static uint8_t nextRising;
+static uint8_t mode;
+static uint8_t flags;
+static uint8_t param;
+static uint64_t runningTime; // MODE_TIMESTAMPS, sum of the steps so far
+static uint32_t lastEdge; // previous generator capture
+static uint8_t hasLastEdge;
+static IR_Decoder_t decoder;
+static IR_Message_t message;
+
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint32_t fakeDmaRemaining(void);
+static uint32_t fakeRisingRemaining(void);
+static void write(const uint32_t *values, uint16_t count);
+static void writeRing(uint32_t value);
+static void writeEdges(const uint32_t *times, uint16_t count);
+static void decode(void);
+static void checkDecoder(void);
+static void fuzzRaw(const uint8_t *input, size_t size);
+static void fuzzGenerator(const uint8_t *input, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *input, size_t size)
+{
+    if (size < HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    mode = input[0] % MODES;
+    flags = input[1];
+    param = input[6];
+    memset(data, 0, sizeof(data));
+    memset(risingData, 0, sizeof(risingData));
+    memset(durationData, 0, sizeof(durationData));
+    dmaIndex = 0;
+    risingDmaIndex = 0;
+    nextRising = 0;
+    runningTime = 0;
+    hasLastEdge = 0;
+    IR_Decoder_ConfigDefaults(&decoder);
+    decoder.buffer = data;
+    decoder.bufferSize = 4 + input[2] % (MAX_BUFFER_SIZE - 3);
+    decoder.clockSpeed = CLOCK_SPEED_MHZ;
+    decoder.period = PERIOD;
+    decoder.message = &message;
+    decoder.decodeCallback = &decodeFinished_callback;
+    decoder.captureRemaining = flags & FLAG_DMA || (mode >= MODE_CARRIER && mode <= MODE_DUAL_RING) ?
+                               &fakeDmaRemaining : NULL;
+    if (mode == MODE_CARRIER)
+    {
+        decoder.carrierGap = 1 + param;
+    }
+    else if (mode == MODE_DURATION_RING)
+    {
+        decoder.durationBuffer = durationData;
+    }
+    else if (mode == MODE_DUAL_RING)
+    {
+        decoder.risingBuffer = risingData;
+        decoder.risingRemaining = &fakeRisingRemaining;
+    }
+    IR_Decoder_Init(&decoder);
+
+    // start from any reachable state
+    decoder.currentIndex = input[3] % decoder.bufferSize;
+    dmaIndex = decoder.currentIndex;
+    decoder.state = (DecoderState)(input[4] % (Resync + 1));
+    decoder.pulseNumber = decoder.state == LeadIn || decoder.state == Resync ? 0 :
+                          (decoder.state - Address) * 8 + input[5] % 8;
+
+    if (flags & FLAG_GENERATOR && mode != MODE_SAMPLES)
+    {
+        fuzzGenerator(input + HEADER_SIZE, size - HEADER_SIZE);
+    }
+    else
+    {
+        fuzzRaw(input + HEADER_SIZE, size - HEADER_SIZE);
+    }
+
+    return 0;
+}
+
+static void fuzzRaw(const uint8_t *input, size_t size)
+{
+    uint32_t values[MAX_BUFFER_SIZE];
+
+    while (size)
+    {
+        uint8_t count = input[0] % decoder.bufferSize;
+
+        input++;
+        size--;
+        if (size < count * sizeof(uint32_t))
+        {
+            count = size / sizeof(uint32_t);
+        }
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            values[i] = (uint32_t)input[0] | (uint32_t)input[1] << 8 | (uint32_t)input[2] << 16 | (uint32_t)input[3] << 24;
+            input += sizeof(uint32_t);
+            size -= sizeof(uint32_t);
+        }
+
+        write(values, count);
+        decode();
+    }
+}
+
+static void fuzzGenerator(const uint8_t *input, size_t size)
+{
+    IR_Generator_t generator;
+    uint32_t edges[IR_GENERATOR_MAX_EDGES];
+    uint8_t frames = 0;
+    // the dual rings hold half the edges each
+    uint16_t piece = mode == MODE_DUAL_RING ? 2 * (decoder.bufferSize - 1) : decoder.bufferSize - 1;
+
+    if (size < 7)
+    {
+        return;
+    }
+
+    generator.period = PERIOD;
+    generator.clockSpeed = CLOCK_SPEED_MHZ;
+    IR_Generator_Init(&generator, 1000,
+                      (uint32_t)input[0] | (uint32_t)input[1] << 8 | (uint32_t)input[2] << 16 | (uint32_t)input[3] << 24);
+    generator.jitter = input[4] * 4;
+    generator.glitchRate = input[5] << 6;
+    generator.dropRate = input[6] << 6;
+    input += 7;
+    size -= 7;
+
+    while (size >= 3 && frames++ < MAX_FRAMES)
+    {
+        uint16_t count = IR_Generator_Frame(&generator, input[0], input[1], edges);
+
+        // write in ring sized pieces so the DMA never laps the decoder
+        for (uint16_t i = 0; i < count; i += piece)
+        {
+            writeEdges(&edges[i], count - i < piece ? count - i : piece);
+            decode();
+        }
+
+        for (uint8_t repeat = 0; repeat < input[2] % 4; repeat++)
+        {
+            writeEdges(edges, IR_Generator_Repeat(&generator, edges));
+            decode();
+        }
+
+        input += 3;
+        size -= 3;
+    }
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    if (!pMessage || pMessage != &message)
+    {
+        abort();
+    }
+}
+
+static uint32_t fakeDmaRemaining(void)
+{
+    return decoder.bufferSize - dmaIndex;
+}
+
+static uint32_t fakeRisingRemaining(void)
+{
+    return decoder.bufferSize - risingDmaIndex;
+}
+
+static void write(const uint32_t *values, uint16_t count)
+{
+    uint64_t times[MAX_BUFFER_SIZE];
+    uint16_t widths[MAX_BUFFER_SIZE];
+
+    switch (mode)
+    {
+        case MODE_TIMESTAMPS:
+            for (uint16_t i = 0; i < count; i++)
+            {
+                runningTime += values[i];
+                times[i] = runningTime;
+            }
+            IR_Decoder_DecodeTimestamps(&decoder, times, count);
+            break;
+        case MODE_DURATIONS:
+            for (uint16_t i = 0; i < count; i++)
+            {
+                widths[i] = (uint16_t)values[i];
+            }
+            IR_Decoder_DecodeDurations(&decoder, widths, count);
+            break;
+        case MODE_SAMPLES:
+            IR_Decoder_DecodeSamples(&decoder, values, count, 100 * (1 + (uint32_t)param));
+            break;
+        case MODE_RING:
+        case MODE_CARRIER:
+        case MODE_DURATION_RING:
+        case MODE_DUAL_RING:
+        default:
+            for (uint16_t i = 0; i < count; i++)
+            {
+                writeRing(values[i]);
+            }
+            break;
+    }
+}
+
+static void writeRing(uint32_t value)
+{
+    // edges alternate, a frame starts with a falling one
+    if (mode == MODE_DUAL_RING && nextRising)
+    {
+        risingData[risingDmaIndex] = value;
+        risingDmaIndex = (risingDmaIndex + 1) % decoder.bufferSize;
+        if (!risingDmaIndex)
+        {
+            IR_Decoder_RisingWrapped(&decoder);
+        }
+        nextRising = 0;
+        return;
+    }
+
+    if (mode == MODE_DURATION_RING)
+    {
+        durationData[dmaIndex] = (uint16_t)value;
+    }
+    else
+    {
+        data[dmaIndex] = value;
+    }
+    dmaIndex = (dmaIndex + 1) % decoder.bufferSize;
+    if (!dmaIndex)
+    {
+        IR_Decoder_CaptureWrapped(&decoder);
+    }
+    nextRising = mode == MODE_DUAL_RING;
+}
+
+// convert the generator's captures to what the mode decodes
+static void writeEdges(const uint32_t *times, uint16_t count)
+{
+    uint32_t values[IR_GENERATOR_MAX_EDGES];
+    uint16_t written = 0;
+
+    if (mode != MODE_TIMESTAMPS && mode != MODE_DURATION_RING && mode != MODE_DURATIONS)
+    {
+        write(times, count);
+        return;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint32_t ticks = hasLastEdge ? (times[i] + PERIOD - lastEdge) % PERIOD : times[i];
+
+        if (mode == MODE_TIMESTAMPS)
+        {
+            values[written++] = ticks;
+        }
+        // the duration ring starts with the idle width, DecodeDurations with the lead-in mark
+        else if (hasLastEdge)
+        {
+            values[written++] = ticks / CLOCK_SPEED_MHZ > IDLE_WIDTH ? IDLE_WIDTH : ticks / CLOCK_SPEED_MHZ;
+        }
+        else if (mode == MODE_DURATION_RING)
+        {
+            values[written++] = IDLE_WIDTH;
+        }
+        lastEdge = times[i];
+        hasLastEdge = 1;
+    }
+
+    write(values, written);
+}
+
+static void decode(void)
+{
+    if (flags & FLAG_BOUNDED && mode <= MODE_DUAL_RING)
+    {
+        while (IR_Decoder_DecodeBounded(&decoder, 1 + param % 4))
+        {
+            checkDecoder();
+        }
+    }
+    else if (mode <= MODE_DUAL_RING)
+    {
+        IR_Decoder_Decode(&decoder);
+    }
+    checkDecoder();
+}
+
+static void checkDecoder(void)
+{
+    if (decoder.currentIndex >= decoder.bufferSize ||
+        decoder.writeIndex >= decoder.bufferSize ||
+        decoder.risingIndex >= decoder.bufferSize ||
+        decoder.pulseNumber >= 32 ||
+        decoder.state > Resync ||
+        ((decoder.state == LeadIn || decoder.state == Resync) && decoder.pulseNumber) ||
+        (decoder.state >= Address && decoder.state <= CommandInv &&
+         decoder.state != (DecoderState)(Address + decoder.pulseNumber / 8)))
+    {
+        abort();
+    }
+}
+
+#ifdef IR_FUZZ_MAIN
+#include <stdio.h>
+
+// replay inputs given as files, or stdin for AFL style drivers
+int main(int argc, char **argv)
+{
+    static uint8_t input[1 << 16];
+
+    for (int i = 1; i < argc || i == 1; i++)
+    {
+        FILE *file = argc > 1 ? fopen(argv[i], "rb") : stdin;
+        size_t size;
+
+        if (!file)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        size = fread(input, 1, sizeof(input), file);
+        if (file != stdin)
+        {
+            fclose(file);
+        }
+
+        LLVMFuzzerTestOneInput(input, size);
+    }
+
+    return 0;
+}
+#endif
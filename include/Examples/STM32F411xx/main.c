@@ -54,6 +54,7 @@ static uint32_t data[BUFFER_SIZE];
 static char string[100];
 static uint8_t size;
 static IR_Decoder_t *pDecoder;
+static volatile uint32_t overflows;
 
 /* USER CODE BEGIN PV */
 
@@ -67,6 +68,8 @@ static void MX_USART2_UART_Init(void);
 static void MX_TIM5_Init(void);
 /* USER CODE BEGIN PFP */
 static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint32_t dmaRemaining_callback(void);
+static uint64_t captureNow_callback(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -84,6 +87,8 @@ int main(void)
 	IR_Message_t message;
 
 	pDecoder = &decoder;
+	// every option off, then only what this board uses
+	IR_Decoder_ConfigDefaults(pDecoder);
 	pDecoder->message = &message;
 	pDecoder->buffer = data;
     pDecoder->bufferSize = BUFFER_SIZE;
@@ -91,6 +96,15 @@ int main(void)
     pDecoder->period = PERIOD;
 
     pDecoder->decodeCallback = &decodeFinished_callback;
+    pDecoder->captureRemaining = &dmaRemaining_callback;
+    // timers without both edge capture can capture falling edges into data and rising edges on a second
+    // channel of the same input (TIM_ICSELECTION_INDIRECTTI) into risingBuffer, see IR_Decoder_RisingWrapped
+    // TIM5 extended by its overflows, places the ring captures and each frame's first and last edge
+    pDecoder->captureNow = &captureNow_callback;
+#ifdef IR_DECODER_TRACE
+    // the same clock for the latency of each frame, the counter alone wraps every 100ms
+    pDecoder->traceTime = &captureNow_callback;
+#endif
     IR_Decoder_Init(pDecoder);
   /* USER CODE END 1 */
 
@@ -119,6 +133,10 @@ int main(void)
   bufferpointer = 0;
   size = 0;
   memset(data, 0, sizeof(data));
+  // the decoder is called from the TIM5 update and the TIM5_CH1 DMA half and full transfer interrupts, it is
+  // not reentrant so they share one preemption priority and never interrupt each other
+  HAL_NVIC_SetPriority(TIM5_IRQn, 1, 0);
+  HAL_NVIC_SetPriority(DMA1_Stream2_IRQn, 1, 0);
   __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_UPDATE);
   HAL_TIM_IC_Start_DMA(&htim5, 0, data, BUFFER_SIZE);
   /* USER CODE END 2 */
@@ -325,12 +343,39 @@ static void decodeFinished_callback(IR_Message_t *pMessage)
     }
 }
 
+static uint32_t dmaRemaining_callback(void)
+{
+	return __HAL_DMA_GET_COUNTER(&hdma_tim5_ch1);
+}
+
+static uint64_t captureNow_callback(void)
+{
+	// called at the update interrupt's priority, a wrap it has not counted yet is still pending
+	uint32_t count = __HAL_TIM_GET_COUNTER(&htim5);
+
+	return IR_Decoder_ExtendCapture(pDecoder, count, overflows, __HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_UPDATE) != RESET);
+}
+
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
+	overflows++;
 	// call decoder
 	IR_Decoder_Decode(pDecoder);
 
 }
+
+void HAL_TIM_IC_CaptureHalfCpltCallback(TIM_HandleTypeDef *htim)
+{
+	// decode before the DMA wraps onto unread edges
+	IR_Decoder_Decode(pDecoder);
+}
+
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+{
+	// transfer complete, the DMA has wrapped back to the start of the buffer
+	IR_Decoder_CaptureWrapped(pDecoder);
+	IR_Decoder_Decode(pDecoder);
+}
 /* USER CODE END 4 */
 
 /**
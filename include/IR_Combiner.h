@@ -0,0 +1,38 @@
+#ifndef IR_COMBINER_H
+#define IR_COMBINER_H
+
+#include <stdint.h>
+
+#include "IR_Decoder.h"
+
+// merges the frames of several decoders watching the same room, each decoder hands its frames to
+// IR_Combiner_Callback with the combiner as callbackContext; without lock and unlock the callback and
+// IR_Combiner_Poll must be called from the same context
+typedef struct IR_Combiner_s {
+    uint32_t window; // us, copies of a frame reported within this time of the first are merged
+    uint32_t (*getTime)(void); // us, free running, wraps
+    void (*decodeCallback)(IR_Message_t*); // called with the lock held
+    uint32_t (*lock)(void); // optional, set after init, held around every slot update, e.g. saves PRIMASK and
+                            // disables the decoders' interrupts so IR_Combiner_Poll can run in the main loop
+    void (*unlock)(uint32_t state); // restores what lock returned
+    IR_Message_t message; // passed to decodeCallback
+    uint32_t frame; // bits merged so far, same layout as IR_Decoder_t frame
+    uint32_t known; // bits some receiver decoded without error
+    uint32_t start; // getTime of the first copy
+    uint8_t pending; // a damaged frame waiting for more copies
+    uint8_t delivered; // the frame at start went out, later copies are dropped
+    uint8_t repeat;
+    uint16_t merged; // frames only clean after merging copies
+    uint16_t copies; // copies dropped after their frame went out
+} IR_Combiner_t;
+
+void IR_Combiner_Init(IR_Combiner_t *combiner, uint32_t window, uint32_t (*getTime)(void),
+                      void (*decodeCallback)(IR_Message_t*));
+// contextCallback for the decoders, a frame goes out once every bit is decoded, a command failing its inverse
+// with those bits flagged as errors; the first copy of a damaged frame is held until other copies fill in its
+// bad bits, the window ends or a repeat arrives, and a repeat carries the merged address and command
+void IR_Combiner_Callback(void *context, IR_Message_t *message);
+// call from the main loop, delivers a damaged frame with its remaining errors once the window has ended
+void IR_Combiner_Poll(IR_Combiner_t *combiner);
+
+#endif
@@ -1,16 +1,57 @@
 #ifndef IR_RECEIVER_H
 #define IR_RECEIVER_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#ifndef IR_DECODER_CACHE_LINE
+#define IR_DECODER_CACHE_LINE 64
+#endif
+
+// the timestamp ring and IR_Decoder_DecodeTimestamps are always built, the other inputs only when asked for:
+// IR_DECODER_DURATIONS the duration ring, IR_Decoder_DecodeDurations and IR_Decoder_ToDurations,
+// IR_DECODER_DUAL_RING the rising edge ring, IR_DECODER_SAMPLES IR_Decoder_DecodeSamples and
+// IR_DECODER_CARRIER carrierGap
+
+#ifdef IR_DECODER_RECORDER
+struct IR_Recorder_s;
+#endif
+
 typedef enum {
     LeadIn = 0,
     Address,
     AddressInv,
     Command,
     CommandInv,
+    Resync, // waiting for a lead-in after lost edges, repeats are ignored
 } DecoderState;
 
+// pulse widths are classified through a table of 2^IR_TIMING_BUCKET_SHIFT us buckets, windows must end below
+// IR_TIMING_BUCKETS of them (10240us)
+#define IR_TIMING_BUCKET_SHIFT 5
+#define IR_TIMING_BUCKETS      320
+#define IR_TIMING_CLASSES      6
+
+// a set of NEC pulse windows in us, bounds are exclusive; fill the windows, or start from IR_Timing_Default,
+// then IR_Timing_Build before handing it to IR_Decoder_SetTiming, and leave it alone while a decoder uses it
+typedef struct IR_Timing_s {
+    uint16_t leadInMarkLow;
+    uint16_t leadInMarkHigh;
+    uint16_t leadInSpaceLow;
+    uint16_t leadInSpaceHigh;
+    uint16_t repeatSpaceLow;
+    uint16_t repeatSpaceHigh;
+    uint16_t shortLow; // a mark, or the space of a 0
+    uint16_t shortHigh;
+    uint16_t longLow; // the space of a 1
+    uint16_t longHigh;
+    uint16_t edgeTimeout; // a gap this long within a frame abandons it
+    // built from the windows
+    uint16_t lowBound[IR_TIMING_CLASSES];
+    uint16_t highBound[IR_TIMING_CLASSES];
+    uint8_t classTable[IR_TIMING_BUCKETS];
+} IR_Timing_t;
+
 typedef struct IR_Message_s {
     uint8_t address;
     uint8_t addressInv;
@@ -21,6 +62,17 @@ typedef struct IR_Message_s {
     uint8_t addressInvError;
     uint8_t commandError;
     uint8_t commandInvError;
+#ifdef IR_DECODER_QUALITY
+    uint16_t meanDeviation; // us, mean distance of the frame's marks and spaces from their nominal widths
+    uint16_t maxDeviation; // us
+#endif
+    uint64_t firstEdge; // capture starting the lead-in, as written to the ring or given to DecodeTimestamps,
+                        // on the captureNow clock when that is set, 0 when decoding durations or samples
+    uint64_t lastEdge; // capture that completed the frame or repeat, the end of its last space
+#ifdef IR_DECODER_TRACE
+    uint64_t decodeTime; // traceTime when the decode call that completed the frame started
+    uint64_t callbackTime; // traceTime just before the callback
+#endif
 } IR_Message_t;
 
 typedef struct IR_Decoder_s {
@@ -28,15 +80,154 @@ typedef struct IR_Decoder_s {
     uint32_t *buffer;
     uint8_t bufferSize;
     uint8_t currentIndex;
-    uint8_t pulseNumber;
+    uint8_t pulseNumber; // bit position within the 32 bit frame
     uint8_t clockSpeed; // MHz
     uint8_t clearLast;
+    uint8_t writeIndex; // DMA write position sampled at the start of each decode
+    volatile uint16_t captureWraps; // DMA laps, see IR_Decoder_CaptureWrapped
+    uint16_t readWraps; // decoder laps of currentIndex
+    uint16_t overruns; // times the DMA lapped the decoder and unread edges were dropped
+    uint16_t quietDecodes; // consecutive decode calls that saw no new edges
+    uint16_t duplicates; // frames dropped by duplicateWindow
+    uint16_t timeouts; // frames abandoned when the gap between two edges, or the quiet time seen by
+                       // IR_Decoder_IsIdle, reached the edge timeout
+    uint32_t duplicateWindow; // us, a clean frame equal to the last one whose lead-in starts within this time
+                              // of the last one's final bit is dropped before the callback, 0 disables; only
+                              // applied where the gap is known, i.e. IR_Decoder_DecodeTimestamps, the duration
+                              // inputs and samples, and the timestamp rings with captureNow set, whose captures
+                              // wrap at period so their gap may otherwise be whole periods longer than it reads
+    uint64_t (*captureNow)(void); // optional, now on the capture clock counting past period, e.g. the counter
+                                  // through IR_Decoder_ExtendCapture; places the timestamp ring captures, each
+                                  // must then be decoded within a period of being taken
+    uint32_t sinceFrame; // us since the final bit of the last frame, saturating, UINT32_MAX if unknown
+    uint8_t wrappedWidths; // set while decoding the timestamp rings, widths are then only known modulo period
+    uint64_t frameEnd; // captureNow ticks of the last frame's final bit on the timestamp rings, UINT64_MAX if unknown
+    uint32_t leadInGap; // sinceFrame when the current frame's lead-in started
+    uint32_t lastFrame; // last frame decoded without errors
+    uint32_t trailingEdge; // capture ending the last frame in the ring, measured up to the next pulse
+    uint8_t hasTrailingEdge;
+#ifdef IR_DECODER_QUALITY
+    uint32_t deviationSum; // us, over the widths of the frame in progress
+    uint16_t deviationMax;
+#endif
     DecoderState state;
+    uint32_t frame; // address, addressInv, command, commandInv from LSB
+    uint32_t frameError; // bits that failed to decode, same layout as frame
+    uint64_t lastEdge; // previous timestamp given to IR_Decoder_DecodeTimestamps, or merged from the two rings
+    uint32_t markTime; // us, mark waiting for its space when decoding a pulse stream
+    uint64_t markStart; // capture starting that mark
+    uint64_t widthStart; // captures bounding the width being decoded, 0 for durations and samples
+    uint64_t widthEnd;
+    uint8_t hasLastEdge;
+    uint8_t hasMark;
     IR_Message_t *message; // may need a 2nd struct
     void (*decodeCallback)(IR_Message_t*);
+    void (*contextCallback)(void *context, IR_Message_t *message); // called instead of decodeCallback when set
+    void *callbackContext; // passed to contextCallback
+    uint32_t (*captureRemaining)(void); // DMA transfers left (NDTR), NULL detects new data by non-zero values
+#ifdef IR_DECODER_RECORDER
+    struct IR_Recorder_s *recorder; // optional trace of every decode call, NULL disables recording
+#endif
+#ifdef IR_DECODER_DURATIONS
+    uint16_t *durationBuffer; // optional DMA ring of widths in us from a timer reset on every edge, widths past
+                              // 65535us should read 65535; used instead of buffer, requires captureRemaining and
+                              // is not recorded
+#endif
+#ifdef IR_DECODER_DUAL_RING
+    uint32_t *risingBuffer; // optional DMA ring of bufferSize rising edge captures from a second timer channel,
+                            // buffer then holds only falling edges; requires captureRemaining and is not recorded
+    uint32_t (*risingRemaining)(void); // DMA transfers left on the rising edge ring
+    uint8_t risingIndex;
+    uint8_t risingWriteIndex;
+    volatile uint16_t risingCaptureWraps; // see IR_Decoder_RisingWrapped
+    uint16_t risingReadWraps;
+#endif
+#ifdef IR_DECODER_SAMPLES
+    uint32_t sampleRun; // samples at sampleLevel so far, see IR_Decoder_DecodeSamples
+    uint16_t sampleRemainder; // ns left over from the last run converted to us
+    uint8_t sampleLevel;
+#endif
+#ifdef IR_DECODER_CARRIER
+    uint16_t carrierGap; // us, for a receiver passing the raw carrier, widths shorter than this are carrier cycles
+                         // merged into one mark, 0 for a demodulating receiver; a frame is far more edges than
+                         // the ring holds, decode at least every bufferSize edges
+    uint32_t carrierBurst; // us of carrier in the mark so far
+    uint32_t carrierOff; // us, the width before the last in the burst, a carrier off half cycle
+    uint32_t carrierLast;
+    uint64_t carrierStart; // capture starting the burst
+#endif
+    const IR_Timing_t *timing; // profile classifying widths, set by IR_Decoder_Init to the IR_Timing.h windows
+    const IR_Timing_t *volatile nextTiming; // see IR_Decoder_SetTiming
+#ifdef IR_DECODER_TRACE
+    uint64_t (*traceTime)(void); // now on the capture clock, may be NULL; counting past period like
+                                 // captureNow, or latencies of a period or more read short
+    uint64_t decodeTime; // traceTime as the current decode call started
+#endif
 } IR_Decoder_t;
 
+#define IR_DECODER_ALIGN(size) (((size) + IR_DECODER_CACHE_LINE - 1) & ~(size_t)(IR_DECODER_CACHE_LINE - 1))
+// bytes for IR_Decoder_Create, usable to size a static block, includes the slack to align any start address
+#define IR_DECODER_SIZE(bufferSize) (IR_DECODER_CACHE_LINE - 1 + \
+                                     IR_DECODER_ALIGN(sizeof(IR_Decoder_t) + sizeof(IR_Message_t)) + \
+                                     IR_DECODER_ALIGN((size_t)(bufferSize) * sizeof(uint32_t)))
+
+// zero every field, optional features off and their pointers NULL; call on a decoder that was not made by
+// IR_Decoder_Create before setting the fields it uses and IR_Decoder_Init
+void IR_Decoder_ConfigDefaults(IR_Decoder_t *receiver);
 void IR_Decoder_Init(IR_Decoder_t *receiver);
+// IR_DECODER_SIZE at runtime
+size_t IR_Decoder_Size(uint8_t bufferSize);
+// place and initialise a decoder, its message and a ring of bufferSize captures in arena, each starting on a
+// cache line, returns NULL if size is too small; other fields can be set before the first decode
+IR_Decoder_t *IR_Decoder_Create(void *arena, size_t size, uint8_t bufferSize, uint8_t clockSpeed, uint32_t period,
+                                void (*decodeCallback)(IR_Message_t*));
 void IR_Decoder_Decode(IR_Decoder_t *receiver);
+// IR_Decoder_Decode processing at most maxPulses (>= 1) mark/space pairs to bound the time spent in an
+// interrupt, returns 1 if more are waiting; calls until it returns 0 give the same results as one
+// IR_Decoder_Decode whatever maxPulses is
+uint8_t IR_Decoder_DecodeBounded(IR_Decoder_t *receiver, uint16_t maxPulses);
+// call from the DMA transfer complete interrupt when captureRemaining is used
+void IR_Decoder_CaptureWrapped(IR_Decoder_t *receiver);
+#ifdef IR_DECODER_DUAL_RING
+// the same for the rising edge ring when risingBuffer is used
+void IR_Decoder_RisingWrapped(IR_Decoder_t *receiver);
+#endif
+// 1 once no frame is in progress and decodes every decodeIntervalMs have seen no edges for idleMs,
+// the caller may then stop polling and sleep until the next edge interrupt; a frame without edges for the
+// edge timeout is abandoned here, so call it from the context that decodes
+uint8_t IR_Decoder_IsIdle(IR_Decoder_t *receiver, uint16_t decodeIntervalMs, uint16_t idleMs);
+// decode monotonic timestamps in timer ticks, e.g. from a 64 bit or chained timer or from
+// IR_Decoder_ExtendCapture, without period wrap handling; the first timestamp must be a falling edge
+void IR_Decoder_DecodeTimestamps(IR_Decoder_t *receiver, const uint64_t *times, uint16_t count);
+#ifdef IR_DECODER_DURATIONS
+// decode pulse widths in us, durations[0] must be a mark
+void IR_Decoder_DecodeDurations(IR_Decoder_t *receiver, const uint16_t *durations, uint16_t count);
+#endif
+#ifdef IR_DECODER_SAMPLES
+// decode the receiver pin sampled every sampleNs and packed 32 samples a word, oldest in bit 0, high while
+// idle; run lengths are found a word at a time so a word without an edge costs one compare
+void IR_Decoder_DecodeSamples(IR_Decoder_t *receiver, const uint32_t *samples, uint16_t count, uint32_t sampleNs);
+#endif
+#ifdef IR_DECODER_DURATIONS
+// convert count absolute captures to count - 1 widths in us for IR_Decoder_DecodeDurations,
+// widths over 65535us are clamped
+uint16_t IR_Decoder_ToDurations(IR_Decoder_t *receiver, const uint32_t *times, uint16_t count, uint16_t *durations);
+#endif
+// extend a capture to a monotonic time, overflows is the count of timer update events when the capture
+// was read and overflowPending the update flag at that moment
+uint64_t IR_Decoder_ExtendCapture(IR_Decoder_t *receiver, uint32_t capture, uint32_t overflows, uint8_t overflowPending);
+// the IR_Timing.h windows, built
+void IR_Timing_Default(IR_Timing_t *timing);
+// derive the lookup tables from the windows, returns 0 if a window is empty, ends past the table or shares
+// a bucket with another window, or if edgeTimeout is not above the short and long windows, which would
+// abandon every frame; the profile is then unusable
+uint8_t IR_Timing_Build(IR_Timing_t *timing);
+// switch to a built profile, NULL for the defaults; safe to call from the main loop while an interrupt decodes
+// on the same core, where the aligned pointer store is atomic; nextTiming is volatile, not atomic, so with the
+// decode on another core or thread call it from the decoding thread; the decoder picks it up once no frame is
+// in progress so the frame being received finishes on the old one
+void IR_Decoder_SetTiming(IR_Decoder_t *receiver, const IR_Timing_t *timing);
+// call after waking on an edge, decodes everything captured while asleep in one pass
+void IR_Decoder_Resume(IR_Decoder_t *receiver);
 
 #endif
\ No newline at end of file
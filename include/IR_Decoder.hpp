@@ -0,0 +1,121 @@
+#ifndef IR_DECODER_HPP
+#define IR_DECODER_HPP
+
+// C++20 wrapper handing decoded frames to coroutines, needs -std=c++20
+
+extern "C"
+{
+#include "IR_Decoder.h"
+}
+
+#include <coroutine>
+#include <deque>
+#include <memory>
+
+namespace IR
+{
+
+// owns a decoder created in its own arena, frames are queued by the context callback and a coroutine
+// waiting in next_frame() is resumed once the decode call has returned, so one thread can serve many
+// decoders and the coroutine may decode again; not movable as the decoder points back at it
+class Decoder
+{
+public:
+    class FrameAwaiter
+    {
+    public:
+        explicit FrameAwaiter(Decoder &owner) : owner(owner) {}
+
+        bool await_ready() const { return !owner.frames.empty(); }
+        // one waiter per decoder
+        void await_suspend(std::coroutine_handle<> handle) { owner.waiter = handle; }
+        IR_Message_t await_resume()
+        {
+            IR_Message_t message = owner.frames.front();
+
+            owner.frames.pop_front();
+            return message;
+        }
+
+    private:
+        Decoder &owner;
+    };
+
+    Decoder(uint8_t bufferSize, uint8_t clockSpeed, uint32_t period)
+        : arena(new unsigned char[IR_Decoder_Size(bufferSize)]),
+          decoder(IR_Decoder_Create(arena.get(), IR_Decoder_Size(bufferSize), bufferSize, clockSpeed, period, nullptr))
+    {
+        decoder->contextCallback = &Decoder::frame_callback;
+        decoder->callbackContext = this;
+    }
+
+    Decoder(const Decoder &) = delete;
+    Decoder &operator=(const Decoder &) = delete;
+
+    // for the fields set before the first decode, e.g. captureRemaining
+    IR_Decoder_t *get() { return decoder; }
+
+    FrameAwaiter next_frame() { return FrameAwaiter(*this); }
+    // frames decoded but not yet awaited
+    size_t pending() const { return frames.size(); }
+
+    // decodes the capture ring, does nothing when built with bufferSize 0 for the timestamp, duration and
+    // sample calls only
+    void decode()
+    {
+        if (!decoder->bufferSize)
+        {
+            return;
+        }
+        IR_Decoder_Decode(decoder);
+        resume();
+    }
+
+    void decode_timestamps(const uint64_t *times, uint16_t count)
+    {
+        IR_Decoder_DecodeTimestamps(decoder, times, count);
+        resume();
+    }
+
+#ifdef IR_DECODER_DURATIONS
+    void decode_durations(const uint16_t *durations, uint16_t count)
+    {
+        IR_Decoder_DecodeDurations(decoder, durations, count);
+        resume();
+    }
+#endif
+
+#ifdef IR_DECODER_SAMPLES
+    void decode_samples(const uint32_t *samples, uint16_t count, uint32_t sampleNs)
+    {
+        IR_Decoder_DecodeSamples(decoder, samples, count, sampleNs);
+        resume();
+    }
+#endif
+
+private:
+    static void frame_callback(void *context, IR_Message_t *message)
+    {
+        static_cast<Decoder *>(context)->frames.push_back(*message);
+    }
+
+    void resume()
+    {
+        while (waiter && !frames.empty())
+        {
+            std::coroutine_handle<> handle = waiter;
+
+            waiter = nullptr;
+            handle.resume();
+        }
+    }
+
+    std::unique_ptr<unsigned char[]> arena;
+    IR_Decoder_t *decoder;
+    std::deque<IR_Message_t> frames;
+    std::coroutine_handle<> waiter;
+};
+
+} // namespace IR
+
+#endif /* IR_DECODER_HPP */
@@ -0,0 +1,25 @@
+#ifndef IR_ENCODER_H
+#define IR_ENCODER_H
+
+#include <stdint.h>
+
+#include "IR_Decoder.h"
+
+// compare values written per frame and per repeat code
+#define IR_ENCODER_FRAME_EDGES 68
+#define IR_ENCODER_REPEAT_EDGES 4
+
+typedef struct IR_Encoder_s {
+    uint32_t period;
+    uint8_t clockSpeed; // MHz
+    uint32_t time; // timer value of the next frame's first edge
+} IR_Encoder_t;
+
+void IR_Encoder_Init(IR_Encoder_t *encoder, uint32_t start);
+// fill buffer with the output compare toggle times of a frame, returns the number written
+uint8_t IR_Encoder_Frame(IR_Encoder_t *encoder, uint8_t address, uint8_t command, uint32_t *buffer);
+// same as IR_Encoder_Frame but sends the inverted bytes as given, e.g. for extended addresses
+uint8_t IR_Encoder_Message(IR_Encoder_t *encoder, const IR_Message_t *message, uint32_t *buffer);
+uint8_t IR_Encoder_Repeat(IR_Encoder_t *encoder, uint32_t *buffer);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef IR_PROBES_H
+#define IR_PROBES_H
+
+// static tracepoints in the decoder for perf, bpftrace or LTTng, provider ir_decoder:
+//   lead_in(decoder, leadInGap)          a lead-in was accepted, leadInGap in us since the last frame
+//   state(decoder, from, to)             the state machine moved on
+//   bit_error(decoder, bit, mark, space) a bit failed to decode, widths in us
+//   frame(decoder, frame, frameError)    a frame completed
+//   repeat(decoder, count)               a repeat code was published
+// built with IR_DECODER_PROBES each probe is a nop plus an ELF note from sys/sdt.h (systemtap-sdt-dev),
+// otherwise nothing at all
+#ifdef IR_DECODER_PROBES
+#include <sys/sdt.h>
+
+#define IR_PROBE2(name, a, b)       DTRACE_PROBE2(ir_decoder, name, a, b)
+#define IR_PROBE3(name, a, b, c)    DTRACE_PROBE3(ir_decoder, name, a, b, c)
+#define IR_PROBE4(name, a, b, c, d) DTRACE_PROBE4(ir_decoder, name, a, b, c, d)
+#else
+#define IR_PROBE2(name, a, b)       do { } while (0)
+#define IR_PROBE3(name, a, b, c)    do { } while (0)
+#define IR_PROBE4(name, a, b, c, d) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef IR_RECORDER_H
+#define IR_RECORDER_H
+
+#include <stdint.h>
+
+#include "IR_Decoder.h"
+
+// trace layout, multi byte header fields are little endian:
+//   header: 'I' 'R' 'T' version flags bufferSize clockSpeed 0 period[4]
+//   one record per IR_Decoder_Decode call, all varints:
+//     callTime skippedEdges edgeCount then edgeCount zigzag deltas from the previous edge
+#define IR_RECORDER_VERSION 1
+#define IR_RECORDER_HEADER_SIZE 12
+#define IR_RECORDER_FLAG_DMA 0x01
+
+typedef struct IR_Recorder_s {
+    uint8_t *trace;
+    uint32_t size;
+    uint32_t length; // bytes of trace written
+    uint8_t full; // set once a call no longer fit, the trace ends at the previous call
+    uint8_t index; // next ring slot to record
+    uint16_t wraps; // laps of index, compared against captureWraps in DMA mode
+    uint32_t lastEdge;
+    uint32_t (*getTime)(void); // clock sampled at each decode call, may be NULL
+} IR_Recorder_t;
+
+typedef struct IR_Replay_s {
+    const uint8_t *trace;
+    uint32_t length;
+    uint32_t position;
+    uint32_t lastEdge;
+    uint8_t index; // next ring slot to write
+    IR_Decoder_t *decoder;
+} IR_Replay_t;
+
+void IR_Recorder_Init(IR_Recorder_t *recorder, uint8_t *trace, uint32_t size);
+// called by IR_Decoder_Init and IR_Decoder_Decode when decoder->recorder is set, which needs the decoder built
+// with IR_DECODER_RECORDER; replaying does not
+void IR_Recorder_Start(IR_Recorder_t *recorder, IR_Decoder_t *decoder);
+void IR_Recorder_Decode(IR_Recorder_t *recorder, IR_Decoder_t *decoder, uint16_t wraps);
+
+// configures and initialises decoder from the trace header, the caller provides buffer,
+// message and decodeCallback, returns 0 on a bad header, including a zero clock speed or period; only one replay may run at a time per process,
+// captureRemaining takes no context so the replay it reports on is held in a static
+uint8_t IR_Replay_Init(IR_Replay_t *replay, const uint8_t *trace, uint32_t length, IR_Decoder_t *decoder);
+// write the edges seen by the next recorded call into the ring, the caller then runs
+// IR_Decoder_Decode; returns 0 at the end of the trace
+uint8_t IR_Replay_Next(IR_Replay_t *replay, uint32_t *callTime);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef IR_TIMING_H
+#define IR_TIMING_H
+
+// NEC pulse windows in us, bounds are exclusive
+#define LEADIN_LOWPULSE_LOWBOUND 8750
+#define LEADIN_LOWPULSE_HIGHBOUND 9250
+#define LEADIN_HIGHPULSE_LOWBOUND 4250
+#define LEADIN_HIGHPULSE_HIGHBOUND 4750
+#define SHORTPULSE_LOWBOUND 500
+#define SHORTPULSE_HIGHBOUND 600
+#define LONGPULSE_LOWBOUND 1500
+#define LONGPULSE_HIGHBOUND 1800
+#define REPEAT_HIGHPULSE_LOWBOUND 2250
+#define REPEAT_HIGHPULSE_HIGHBOUND 2750
+
+// transmitted widths sit in the middle of each window so encoded frames always decode
+#define LEADIN_LOWPULSE ((LEADIN_LOWPULSE_LOWBOUND + LEADIN_LOWPULSE_HIGHBOUND) / 2)
+#define LEADIN_HIGHPULSE ((LEADIN_HIGHPULSE_LOWBOUND + LEADIN_HIGHPULSE_HIGHBOUND) / 2)
+#define SHORTPULSE ((SHORTPULSE_LOWBOUND + SHORTPULSE_HIGHBOUND) / 2)
+#define LONGPULSE ((LONGPULSE_LOWBOUND + LONGPULSE_HIGHBOUND) / 2)
+#define REPEAT_HIGHPULSE ((REPEAT_HIGHPULSE_LOWBOUND + REPEAT_HIGHPULSE_HIGHBOUND) / 2)
+
+// even a distorted bit stays well short of a lead-in space, a gap this long means the frame was cut short
+#define FRAME_EDGE_TIMEOUT LEADIN_HIGHPULSE_LOWBOUND
+
+// start to start spacing of frames and repeat codes
+#define FRAME_PERIOD 108000
+
+#endif
@@ -0,0 +1,191 @@
+#include "IR_Combiner.h"
+
+// the command byte is sent inverted by both plain and extended NEC, the address only by plain NEC
+#define COMMAND_BITS    0x00FF0000
+#define COMMAND_INVERSE 0xFF000000
+
+static void combine(IR_Combiner_t *combiner, IR_Message_t *message);
+static uint32_t packBits(uint8_t byte0, uint8_t byte1, uint8_t byte2, uint8_t byte3);
+static void inferCommand(IR_Combiner_t *combiner);
+static uint8_t checkComplete(IR_Combiner_t *combiner);
+static uint8_t isCopy(IR_Combiner_t *combiner, uint32_t frame, uint32_t errors, uint32_t now);
+static void deliver(IR_Combiner_t *combiner);
+
+void IR_Combiner_Init(IR_Combiner_t *combiner, uint32_t window, uint32_t (*getTime)(void),
+                      void (*decodeCallback)(IR_Message_t*))
+{
+    combiner->window = window;
+    combiner->getTime = getTime;
+    combiner->decodeCallback = decodeCallback;
+    combiner->lock = NULL;
+    combiner->unlock = NULL;
+    combiner->frame = 0;
+    combiner->known = 0;
+    combiner->start = 0;
+    combiner->pending = 0;
+    combiner->delivered = 0;
+    combiner->repeat = 0;
+    combiner->merged = 0;
+    combiner->copies = 0;
+}
+
+void IR_Combiner_Callback(void *context, IR_Message_t *message)
+{
+    IR_Combiner_t *combiner = context;
+    uint32_t state = combiner->lock ? combiner->lock() : 0;
+
+    combine(combiner, message);
+    if (combiner->unlock)
+    {
+        combiner->unlock(state);
+    }
+}
+
+void IR_Combiner_Poll(IR_Combiner_t *combiner)
+{
+    // a callback between the window check and the delivery would replace the held frame
+    uint32_t state = combiner->lock ? combiner->lock() : 0;
+
+    if (combiner->pending && combiner->getTime() - combiner->start >= combiner->window)
+    {
+        deliver(combiner);
+    }
+    if (combiner->unlock)
+    {
+        combiner->unlock(state);
+    }
+}
+
+static void combine(IR_Combiner_t *combiner, IR_Message_t *message)
+{
+    uint32_t now = combiner->getTime();
+    uint32_t frame = packBits(message->address, message->addressInv, message->command, message->commandInv);
+    uint32_t errors = packBits(message->addressError, message->addressInvError, message->commandError,
+                               message->commandInvError);
+
+    // repeats carry no bits, the first receiver to see one wins
+    if (message->repeat)
+    {
+        if (combiner->repeat && combiner->delivered && now - combiner->start < combiner->window)
+        {
+            combiner->copies++;
+            return;
+        }
+
+        // the frame it repeats goes out first, whatever the window
+        if (combiner->pending)
+        {
+            deliver(combiner);
+        }
+
+        combiner->message = *message;
+        combiner->start = now;
+        combiner->repeat = 1;
+        // it names the frame as merged rather than as this receiver decoded it
+        if (combiner->known)
+        {
+            deliver(combiner);
+            return;
+        }
+
+        combiner->pending = 0;
+        combiner->delivered = 1;
+        combiner->decodeCallback(&combiner->message);
+        return;
+    }
+
+    if (isCopy(combiner, frame, errors, now))
+    {
+        if (combiner->delivered)
+        {
+            combiner->copies++;
+            return;
+        }
+
+        // bits this copy decoded fill the ones still unknown
+        combiner->frame = (combiner->frame & combiner->known) | (frame & ~combiner->known);
+        combiner->known |= ~errors;
+        inferCommand(combiner);
+        if (checkComplete(combiner))
+        {
+            combiner->merged += combiner->known == UINT32_MAX;
+            deliver(combiner);
+        }
+        return;
+    }
+
+    // a different frame, or the window has passed, whatever was held goes out first
+    if (combiner->pending)
+    {
+        deliver(combiner);
+    }
+
+    combiner->message = *message;
+    combiner->frame = frame;
+    combiner->known = ~errors;
+    combiner->start = now;
+    combiner->repeat = 0;
+    combiner->pending = 1;
+    combiner->delivered = 0;
+
+    // a clean copy goes out at once, as a single decoder would have delivered it
+    inferCommand(combiner);
+    if (checkComplete(combiner))
+    {
+        deliver(combiner);
+    }
+}
+
+static uint32_t packBits(uint8_t byte0, uint8_t byte1, uint8_t byte2, uint8_t byte3)
+{
+    return byte0 | (uint32_t)byte1 << 8 | (uint32_t)byte2 << 16 | (uint32_t)byte3 << 24;
+}
+
+static void inferCommand(IR_Combiner_t *combiner)
+{
+    // a bad command bit is the complement of its good inverse bit and the other way round
+    uint32_t fromInverse = (combiner->known >> 8) & ~combiner->known & COMMAND_BITS;
+    uint32_t fromCommand = (combiner->known << 8) & ~combiner->known & COMMAND_INVERSE;
+
+    combiner->frame = (combiner->frame & ~fromInverse) | (~combiner->frame >> 8 & fromInverse);
+    combiner->frame = (combiner->frame & ~fromCommand) | (~combiner->frame << 8 & fromCommand);
+    combiner->known |= fromInverse | fromCommand;
+}
+
+static uint8_t checkComplete(IR_Combiner_t *combiner)
+{
+    uint32_t mismatch = ~(combiner->frame ^ combiner->frame >> 8) & COMMAND_BITS;
+
+    if (combiner->known != UINT32_MAX)
+    {
+        return 0;
+    }
+
+    // no other copy can change a decoded bit, command bits that fail the inverse go out as errors on both
+    combiner->known &= ~(mismatch | mismatch << 8);
+    return 1;
+}
+
+static uint8_t isCopy(IR_Combiner_t *combiner, uint32_t frame, uint32_t errors, uint32_t now)
+{
+    // the same frame if it came within the window and no bit both sides decoded differs
+    return !combiner->repeat && (combiner->pending || combiner->delivered) &&
+           now - combiner->start < combiner->window && !((frame ^ combiner->frame) & combiner->known & ~errors);
+}
+
+static void deliver(IR_Combiner_t *combiner)
+{
+    uint32_t errors = ~combiner->known;
+
+    combiner->message.address = combiner->frame;
+    combiner->message.addressInv = combiner->frame >> 8;
+    combiner->message.command = combiner->frame >> 16;
+    combiner->message.commandInv = combiner->frame >> 24;
+    combiner->message.addressError = errors;
+    combiner->message.addressInvError = errors >> 8;
+    combiner->message.commandError = errors >> 16;
+    combiner->message.commandInvError = errors >> 24;
+    combiner->pending = 0;
+    combiner->delivered = 1;
+    combiner->decodeCallback(&combiner->message);
+}
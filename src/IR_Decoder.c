@@ -1,175 +1,1370 @@
 #include "IR_Decoder.h"
+#include "IR_Probes.h"
+#ifdef IR_DECODER_RECORDER
+#include "IR_Recorder.h"
+#endif
+#include "IR_Timing.h"
 
 #include <string.h>
 
-#define LEADIN_LOWPULSE_LOWBOUND 8750
-#define LEADIN_LOWPULSE_HIGHBOUND 9250
-#define LEADIN_HIGHPULSE_LOWBOUND 4250
-#define LEADIN_HIGHPULSE_HIGHBOUND 4750
-#define SHORTPULSE_LOWBOUND 500
-#define SHORTPULSE_HIGHBOUND 600
-#define LONGPULSE_LOWBOUND 1500
-#define LONGPULSE_HIGHBOUND 1800
-#define REPEAT_HIGHPULSE_LOWBOUND 2250
-#define REPEAT_HIGHPULSE_HIGHBOUND 2750
+#define MAXPULSES 32
 
-#define MAXPULSES 8
+// set on buckets that straddle a window bound and need an exact compare
+#define PULSE_PARTIAL 0x80
+
+typedef enum {
+    PulseNone = 0,
+    PulseShort,
+    PulseLong,
+    PulseRepeatSpace,
+    PulseHeaderSpace,
+    PulseLeadInMark,
+    PulseClasses
+} PulseClass;
+
+typedef enum {
+    SymbolZero = 0,
+    SymbolOne,
+    SymbolHeader,
+    SymbolRepeat,
+    SymbolInvalid
+} PulseSymbol;
+
+// symbol for a (falling, rising) pair indexed by [mark class][space class]
+static const uint8_t pulseSymbol[PulseClasses][PulseClasses] = {
+    [PulseNone] = { SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid },
+    [PulseShort] = { SymbolInvalid, SymbolZero, SymbolOne, SymbolInvalid, SymbolInvalid, SymbolInvalid },
+    [PulseLong] = { SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid },
+    [PulseRepeatSpace] = { SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid },
+    [PulseHeaderSpace] = { SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolInvalid },
+    [PulseLeadInMark] = { SymbolInvalid, SymbolInvalid, SymbolInvalid, SymbolRepeat, SymbolHeader, SymbolInvalid },
+};
+
+// the IR_Timing.h windows with their class table worked out at compile time, one bucket overlaps at most
+// one window so the classes of all windows can be ORed
+#define BUCKET_FIRST(bucket) ((bucket) << IR_TIMING_BUCKET_SHIFT)
+#define BUCKET_LAST(bucket)  (BUCKET_FIRST(bucket) + (1 << IR_TIMING_BUCKET_SHIFT) - 1)
+#define BUCKET_CLASS(bucket, pulseClass, low, high) \
+    (BUCKET_LAST(bucket) > (low) && BUCKET_FIRST(bucket) < (high) ? \
+     (pulseClass) | (BUCKET_FIRST(bucket) <= (low) || BUCKET_LAST(bucket) >= (high) ? PULSE_PARTIAL : 0) : PulseNone)
+#define DEFAULT_CLASS(bucket) \
+    (BUCKET_CLASS(bucket, PulseShort, SHORTPULSE_LOWBOUND, SHORTPULSE_HIGHBOUND) | \
+     BUCKET_CLASS(bucket, PulseLong, LONGPULSE_LOWBOUND, LONGPULSE_HIGHBOUND) | \
+     BUCKET_CLASS(bucket, PulseRepeatSpace, REPEAT_HIGHPULSE_LOWBOUND, REPEAT_HIGHPULSE_HIGHBOUND) | \
+     BUCKET_CLASS(bucket, PulseHeaderSpace, LEADIN_HIGHPULSE_LOWBOUND, LEADIN_HIGHPULSE_HIGHBOUND) | \
+     BUCKET_CLASS(bucket, PulseLeadInMark, LEADIN_LOWPULSE_LOWBOUND, LEADIN_LOWPULSE_HIGHBOUND))
+#define DEFAULT_CLASS4(bucket) \
+    DEFAULT_CLASS(bucket), DEFAULT_CLASS((bucket) + 1), DEFAULT_CLASS((bucket) + 2), DEFAULT_CLASS((bucket) + 3)
+#define DEFAULT_CLASS16(bucket) \
+    DEFAULT_CLASS4(bucket), DEFAULT_CLASS4((bucket) + 4), DEFAULT_CLASS4((bucket) + 8), DEFAULT_CLASS4((bucket) + 12)
+#define DEFAULT_CLASS64(bucket) \
+    DEFAULT_CLASS16(bucket), DEFAULT_CLASS16((bucket) + 16), DEFAULT_CLASS16((bucket) + 32), \
+    DEFAULT_CLASS16((bucket) + 48)
+
+#if IR_TIMING_BUCKETS != 320
+#error "defaultTiming spells out 320 buckets"
+#endif
+
+// shared by every decoder and never written, so an Init cannot race another decoder's interrupt
+static const IR_Timing_t defaultTiming = {
+    .leadInMarkLow = LEADIN_LOWPULSE_LOWBOUND,
+    .leadInMarkHigh = LEADIN_LOWPULSE_HIGHBOUND,
+    .leadInSpaceLow = LEADIN_HIGHPULSE_LOWBOUND,
+    .leadInSpaceHigh = LEADIN_HIGHPULSE_HIGHBOUND,
+    .repeatSpaceLow = REPEAT_HIGHPULSE_LOWBOUND,
+    .repeatSpaceHigh = REPEAT_HIGHPULSE_HIGHBOUND,
+    .shortLow = SHORTPULSE_LOWBOUND,
+    .shortHigh = SHORTPULSE_HIGHBOUND,
+    .longLow = LONGPULSE_LOWBOUND,
+    .longHigh = LONGPULSE_HIGHBOUND,
+    .edgeTimeout = FRAME_EDGE_TIMEOUT,
+    .lowBound = { 0, SHORTPULSE_LOWBOUND, LONGPULSE_LOWBOUND, REPEAT_HIGHPULSE_LOWBOUND, LEADIN_HIGHPULSE_LOWBOUND,
+                  LEADIN_LOWPULSE_LOWBOUND },
+    .highBound = { 0, SHORTPULSE_HIGHBOUND, LONGPULSE_HIGHBOUND, REPEAT_HIGHPULSE_HIGHBOUND,
+                   LEADIN_HIGHPULSE_HIGHBOUND, LEADIN_LOWPULSE_HIGHBOUND },
+    .classTable = { DEFAULT_CLASS64(0), DEFAULT_CLASS64(64), DEFAULT_CLASS64(128), DEFAULT_CLASS64(192),
+                    DEFAULT_CLASS64(256) },
+};
 
 static void clearCurrentIndex(IR_Decoder_t *decoder);
 static void clearMessage(IR_Message_t* message);
+static void extractMessage(IR_Decoder_t *decoder);
 static uint32_t getPulseTime(uint32_t time0, uint32_t time1, uint32_t period, uint8_t clockSpeed);
-static int8_t decodePulse(uint32_t fallingTime, uint32_t risingTime);
+static uint32_t getPulseTicks(uint32_t time0, uint32_t time1, uint32_t period);
+#if defined(IR_DECODER_DUAL_RING) || defined(IR_DECODER_CARRIER)
+static uint32_t getEdgeTime(uint32_t time0, uint32_t time1, uint32_t period, uint8_t clockSpeed);
+#endif
+static void applyTiming(IR_Decoder_t *decoder);
+static uint8_t classifyPulse(const IR_Timing_t *timing, uint32_t pulseTime);
+static uint8_t decodePulse(const IR_Timing_t *timing, uint32_t fallingTime, uint32_t risingTime);
+static uint8_t decodePulseTimes(IR_Decoder_t *decoder, uint32_t fallingTime, uint32_t risingTime);
+static void decodePulseTime(IR_Decoder_t *decoder, uint32_t pulseTime);
+static uint8_t decodeCapture(IR_Decoder_t *decoder, uint16_t maxPulses);
+static uint8_t decodeTimestampRing(IR_Decoder_t *decoder, uint16_t maxPulses);
+static void seekLeadIn(IR_Decoder_t *decoder, uint16_t *maxPulses, uint64_t *skippedTicks);
+static void publishMessage(IR_Decoder_t *decoder);
+#ifdef IR_DECODER_TRACE
+static void traceDecode(IR_Decoder_t *decoder);
+#endif
+static void addElapsed(IR_Decoder_t *decoder, uint32_t pulseTime);
+static void addElapsedTicks(IR_Decoder_t *decoder, uint64_t ticks);
+#ifdef IR_DECODER_DURATIONS
+static void checkDurationClamp(IR_Decoder_t *decoder, uint16_t duration);
+#endif
+static uint64_t placeCapture(IR_Decoder_t *decoder, uint32_t capture);
+static uint64_t placeEdge(IR_Decoder_t *decoder, uint64_t edge);
+static uint32_t getRingGap(IR_Decoder_t *decoder, uint64_t firstEdge);
+static uint8_t isSeeking(IR_Decoder_t *decoder);
+static uint8_t isLeadInMark(const IR_Timing_t *timing, uint32_t pulseTime, uint8_t clockSpeed);
+static uint8_t isLeadInSpace(const IR_Timing_t *timing, uint32_t pulseTime, uint8_t clockSpeed);
+static uint8_t checkEdgeTimeout(IR_Decoder_t *decoder, uint32_t fallingTime, uint32_t risingTime);
+static void abandonFrame(IR_Decoder_t *decoder);
+static uint8_t isDuplicate(IR_Decoder_t *decoder);
+#ifdef IR_DECODER_QUALITY
+static void addDeviation(IR_Decoder_t *decoder, uint32_t pulseTime, uint32_t nominal);
+static void addBitDeviation(IR_Decoder_t *decoder, uint32_t fallingTime, uint32_t risingTime);
+#endif
+#ifdef IR_DECODER_RECORDER
+static uint8_t isTimestampRing(IR_Decoder_t *decoder);
+#endif
+#ifdef IR_DECODER_DURATIONS
+static uint8_t decodeDurationRing(IR_Decoder_t *decoder, uint16_t maxPulses);
+#endif
+#ifdef IR_DECODER_DUAL_RING
+static uint8_t decodeDualRing(IR_Decoder_t *decoder, uint16_t maxPulses);
+static void decodeEdge(IR_Decoder_t *decoder, uint32_t time, uint8_t rising);
+#endif
+#if defined(IR_DECODER_DUAL_RING) || defined(IR_DECODER_SAMPLES) || defined(IR_DECODER_CARRIER)
+static void decodeWidth(IR_Decoder_t *decoder, uint32_t pulseTime, uint8_t mark);
+#endif
+static void decodeCaptured(IR_Decoder_t *decoder, uint32_t pulseTime);
+#ifdef IR_DECODER_CARRIER
+static void demodulate(IR_Decoder_t *decoder, uint32_t pulseTime);
+static uint8_t decodeCarrierRing(IR_Decoder_t *decoder, uint16_t maxPulses);
+#endif
+#ifdef IR_DECODER_SAMPLES
+static uint8_t countTrailingZeros(uint32_t value);
+#endif
+#ifdef IR_DECODER_DUAL_RING
+static void clearRisingIndex(IR_Decoder_t *decoder);
+static int32_t risingLag(IR_Decoder_t *decoder, uint16_t wraps);
+static void recoverDualOverrun(IR_Decoder_t *decoder, uint16_t wraps, uint16_t risingWraps);
+#endif
 static uint8_t areTimestampsValid(uint32_t time0, uint32_t time1, uint32_t time2, uint32_t time3);
+static uint8_t isPulseAvailable(IR_Decoder_t *decoder, uint32_t time0, uint32_t time1, uint32_t time2, uint32_t time3);
+static uint8_t edgesAvailable(IR_Decoder_t *decoder);
+static void checkTrailingEdge(IR_Decoder_t *decoder);
+static int32_t captureLag(IR_Decoder_t *decoder, uint16_t wraps);
+static uint8_t isCaptureOverrun(IR_Decoder_t *decoder, uint16_t wraps);
+static void recoverOverrun(IR_Decoder_t *decoder, uint16_t wraps);
+
+void IR_Decoder_ConfigDefaults(IR_Decoder_t *decoder)
+{
+    // every option is off at zero, fields added later stay off for callers that never heard of them
+    memset(decoder, 0, sizeof(*decoder));
+}
 
 void IR_Decoder_Init(IR_Decoder_t *decoder)
 {
     decoder->currentIndex = 0;
     decoder->pulseNumber = 0;
+    decoder->frame = 0;
+    decoder->frameError = 0;
     decoder->clearLast = 0;
+    decoder->writeIndex = 0;
+    decoder->captureWraps = 0;
+    decoder->readWraps = 0;
+#ifdef IR_DECODER_DUAL_RING
+    decoder->risingIndex = 0;
+    decoder->risingWriteIndex = 0;
+    decoder->risingCaptureWraps = 0;
+    decoder->risingReadWraps = 0;
+#endif
+#ifdef IR_DECODER_SAMPLES
+    decoder->sampleRun = 0;
+    decoder->sampleRemainder = 0;
+    decoder->sampleLevel = 1;
+#endif
+#ifdef IR_DECODER_CARRIER
+    decoder->carrierBurst = 0;
+    decoder->carrierOff = 0;
+    decoder->carrierLast = 0;
+    decoder->carrierStart = 0;
+#endif
+    decoder->overruns = 0;
+    decoder->quietDecodes = 0;
+    decoder->duplicates = 0;
+    decoder->timeouts = 0;
+    decoder->sinceFrame = UINT32_MAX;
+    decoder->leadInGap = UINT32_MAX;
+    decoder->wrappedWidths = 0;
+    decoder->frameEnd = UINT64_MAX;
+    decoder->lastFrame = 0;
+    decoder->trailingEdge = 0;
+    decoder->hasTrailingEdge = 0;
+#ifdef IR_DECODER_QUALITY
+    decoder->deviationSum = 0;
+    decoder->deviationMax = 0;
+#endif
+    decoder->lastEdge = 0;
+    decoder->markTime = 0;
+    decoder->markStart = 0;
+    decoder->widthStart = 0;
+    decoder->widthEnd = 0;
+#ifdef IR_DECODER_TRACE
+    decoder->decodeTime = 0;
+#endif
+    decoder->hasLastEdge = 0;
+    decoder->hasMark = 0;
     decoder->state = LeadIn;
+    decoder->timing = &defaultTiming;
+    decoder->nextTiming = &defaultTiming;
     if (decoder->message)
     {
         clearMessage(decoder->message);
     }
-    memset(decoder->buffer, 0, decoder->bufferSize * sizeof(*(decoder->buffer)));
+#ifdef IR_DECODER_DURATIONS
+    if (decoder->durationBuffer)
+    {
+        // the first width captured is the idle time before the first falling edge, pair it with
+        // an empty mark so the next width starts a mark
+        decoder->hasMark = 1;
+        memset(decoder->durationBuffer, 0, decoder->bufferSize * sizeof(*(decoder->durationBuffer)));
+    }
+    else
+#endif
+    // decoders fed only through IR_Decoder_DecodeTimestamps need no ring
+    if (decoder->buffer)
+    {
+        memset(decoder->buffer, 0, decoder->bufferSize * sizeof(*(decoder->buffer)));
+    }
+#ifdef IR_DECODER_DUAL_RING
+    if (decoder->risingBuffer)
+    {
+        memset(decoder->risingBuffer, 0, decoder->bufferSize * sizeof(*(decoder->risingBuffer)));
+    }
+#endif
+#ifdef IR_DECODER_RECORDER
+    if (decoder->recorder)
+    {
+        IR_Recorder_Start(decoder->recorder, decoder);
+    }
+#endif
 }
 
-void IR_Decoder_Decode(IR_Decoder_t *decoder)
+void IR_Decoder_CaptureWrapped(IR_Decoder_t *decoder)
 {
-    uint32_t time0 = decoder->buffer[decoder->currentIndex];
-    uint32_t time1 = decoder->buffer[(decoder->currentIndex + 1) % decoder->bufferSize];
-    uint32_t time2 = decoder->buffer[(decoder->currentIndex + 2) % decoder->bufferSize];
-    uint32_t time3 = decoder->buffer[(decoder->currentIndex + 3) % decoder->bufferSize];
+    decoder->captureWraps++;
+}
 
-    // check if cleanup from last decode call is required
-    if (decoder->clearLast)
+#ifdef IR_DECODER_DUAL_RING
+void IR_Decoder_RisingWrapped(IR_Decoder_t *decoder)
+{
+    decoder->risingCaptureWraps++;
+}
+#endif
+
+size_t IR_Decoder_Size(uint8_t bufferSize)
+{
+    return IR_DECODER_SIZE(bufferSize);
+}
+
+IR_Decoder_t *IR_Decoder_Create(void *arena, size_t size, uint8_t bufferSize, uint8_t clockSpeed, uint32_t period,
+                                void (*decodeCallback)(IR_Message_t*))
+{
+    uintptr_t start = IR_DECODER_ALIGN((uintptr_t)arena);
+    IR_Decoder_t *decoder = (IR_Decoder_t *)start;
+
+    if (!arena || size < IR_DECODER_SIZE(bufferSize))
+    {
+        return NULL;
+    }
+
+    // the message shares the decoder's lines, the ring written by DMA starts on its own
+    IR_Decoder_ConfigDefaults(decoder);
+    decoder->message = (IR_Message_t *)(decoder + 1);
+    decoder->buffer = bufferSize ? (uint32_t *)(start + IR_DECODER_ALIGN(sizeof(IR_Decoder_t) + sizeof(IR_Message_t))) : NULL;
+    decoder->bufferSize = bufferSize;
+    decoder->clockSpeed = clockSpeed;
+    decoder->period = period;
+    decoder->decodeCallback = decodeCallback;
+    IR_Decoder_Init(decoder);
+
+    return decoder;
+}
+
+void IR_Timing_Default(IR_Timing_t *timing)
+{
+    *timing = defaultTiming;
+}
+
+uint8_t IR_Timing_Build(IR_Timing_t *timing)
+{
+    // in PulseClass order
+    const uint16_t low[PulseClasses] = { 0, timing->shortLow, timing->longLow, timing->repeatSpaceLow,
+                                         timing->leadInSpaceLow, timing->leadInMarkLow };
+    const uint16_t high[PulseClasses] = { 0, timing->shortHigh, timing->longHigh, timing->repeatSpaceHigh,
+                                          timing->leadInSpaceHigh, timing->leadInMarkHigh };
+
+    // the timeout is only checked between the lead-in and the stop bit, where every width is a bit's
+    if (timing->edgeTimeout <= timing->shortHigh || timing->edgeTimeout <= timing->longHigh)
+    {
+        return 0;
+    }
+
+    for (uint8_t pulseClass = PulseShort; pulseClass < PulseClasses; pulseClass++)
     {
-        decoder->buffer[decoder->currentIndex ? decoder->currentIndex - 1 : decoder->bufferSize - 1] = 0;
-        decoder->clearLast = 0;
+        if (low[pulseClass] + 1 >= high[pulseClass] || high[pulseClass] > IR_TIMING_BUCKETS << IR_TIMING_BUCKET_SHIFT)
+        {
+            return 0;
+        }
+        timing->lowBound[pulseClass] = low[pulseClass];
+        timing->highBound[pulseClass] = high[pulseClass];
     }
+    timing->lowBound[PulseNone] = 0;
+    timing->highBound[PulseNone] = 0;
 
-    while (areTimestampsValid(time0, time1, time2, time3))
+    for (uint16_t bucket = 0; bucket < IR_TIMING_BUCKETS; bucket++)
     {
-        uint32_t fallingTime = getPulseTime(time0, time1, decoder->period, decoder->clockSpeed);
-        uint32_t risingTime = getPulseTime(time1, time2, decoder->period, decoder->clockSpeed);
-        int8_t signal = decodePulse(fallingTime, risingTime);
+        uint32_t first = (uint32_t)bucket << IR_TIMING_BUCKET_SHIFT;
+        uint32_t last = first + (1 << IR_TIMING_BUCKET_SHIFT) - 1;
+        uint8_t entry = PulseNone;
 
-        switch (decoder->state)
+        // a bucket holds one partial compare, windows closer than that cannot be told apart by the table
+        for (uint8_t pulseClass = PulseShort; pulseClass < PulseClasses; pulseClass++)
         {
-        case LeadIn:
-            if (fallingTime < LEADIN_LOWPULSE_HIGHBOUND && fallingTime > LEADIN_LOWPULSE_LOWBOUND)
+            if (last > low[pulseClass] && first < high[pulseClass])
             {
-                if (risingTime < LEADIN_HIGHPULSE_HIGHBOUND && risingTime > LEADIN_HIGHPULSE_LOWBOUND)
+                if (entry != PulseNone)
                 {
-                    decoder->state = Address;
-
-                    // clear message buffer for new message
-                    clearMessage(decoder->message);
+                    return 0;
                 }
-                else if (risingTime < REPEAT_HIGHPULSE_HIGHBOUND && risingTime > REPEAT_HIGHPULSE_LOWBOUND)
+
+                entry = pulseClass;
+                if (first <= low[pulseClass] || last >= high[pulseClass])
                 {
-                    decoder->message->repeat++;
-                    decoder->decodeCallback(decoder->message);
-                    clearCurrentIndex(decoder);
-                    clearCurrentIndex(decoder);
+                    entry |= PULSE_PARTIAL;
                 }
             }
-            break;
-        case Address:
-            if (signal >= 0)
+        }
+
+        timing->classTable[bucket] = entry;
+    }
+
+    return 1;
+}
+
+void IR_Decoder_SetTiming(IR_Decoder_t *decoder, const IR_Timing_t *timing)
+{
+    // a single pointer store, applyTiming reads it between frames
+    decoder->nextTiming = timing ? timing : &defaultTiming;
+}
+
+void IR_Decoder_Decode(IR_Decoder_t *decoder)
+{
+    // more pulses than any ring can hold
+    decodeCapture(decoder, UINT16_MAX);
+}
+
+uint8_t IR_Decoder_DecodeBounded(IR_Decoder_t *decoder, uint16_t maxPulses)
+{
+    return decodeCapture(decoder, maxPulses);
+}
+
+static uint8_t decodeCapture(IR_Decoder_t *decoder, uint16_t maxPulses)
+{
+    uint8_t startIndex = decoder->currentIndex;
+    uint8_t startWriteIndex = decoder->writeIndex;
+#ifdef IR_DECODER_DUAL_RING
+    uint8_t startRisingIndex = decoder->risingIndex;
+#endif
+    uint8_t pending;
+    uint8_t moved;
+
+#ifdef IR_DECODER_TRACE
+    traceDecode(decoder);
+#endif
+    applyTiming(decoder);
+    if (decoder->captureRemaining)
+    {
+        uint16_t wraps;
+#ifdef IR_DECODER_DUAL_RING
+        uint16_t risingWraps = 0;
+
+        // sampled back to back with the falling ring, only two edges within the few cycles between the
+        // reads could be merged out of order
+        if (decoder->risingBuffer)
+        {
+            do
             {
-                decoder->message->address |= signal << decoder->pulseNumber;
-            }
-            else
+                risingWraps = decoder->risingCaptureWraps;
+                decoder->risingWriteIndex = (decoder->bufferSize - decoder->risingRemaining()) % decoder->bufferSize;
+            } while (risingWraps != decoder->risingCaptureWraps);
+        }
+#endif
+
+        // NDTR counts down from bufferSize and reloads in circular mode, resample
+        // if the transfer complete interrupt fired in between
+        do
+        {
+            wraps = decoder->captureWraps;
+            decoder->writeIndex = (decoder->bufferSize - decoder->captureRemaining()) % decoder->bufferSize;
+        } while (wraps != decoder->captureWraps);
+
+#ifdef IR_DECODER_RECORDER
+        if (decoder->recorder && isTimestampRing(decoder))
+        {
+            IR_Recorder_Decode(decoder->recorder, decoder, wraps);
+        }
+#endif
+
+#ifdef IR_DECODER_DUAL_RING
+        if (decoder->risingBuffer)
+        {
+            if (isCaptureOverrun(decoder, wraps) || risingLag(decoder, risingWraps) >= decoder->bufferSize)
             {
-                decoder->message->addressError |= 1 << decoder->pulseNumber;
+                recoverDualOverrun(decoder, wraps, risingWraps);
             }
+        }
+        else
+#endif
+        if (isCaptureOverrun(decoder, wraps))
+        {
+            recoverOverrun(decoder, wraps);
+        }
+        // the trailing edge skipped at the end of the last frame has since been written
+        else if (decoder->clearLast &&
+            decoder->writeIndex != (decoder->currentIndex ? decoder->currentIndex - 1 : decoder->bufferSize - 1))
+        {
+            decoder->clearLast = 0;
+        }
+    }
+    else
+    {
+#ifdef IR_DECODER_RECORDER
+        if (decoder->recorder)
+        {
+            IR_Recorder_Decode(decoder->recorder, decoder, 0);
+        }
+#endif
+
+        // check if cleanup from last decode call is required
+        if (decoder->clearLast)
+        {
+            decoder->buffer[decoder->currentIndex ? decoder->currentIndex - 1 : decoder->bufferSize - 1] = 0;
+            decoder->clearLast = 0;
+        }
+    }
+
+    // every ring but the duration ring holds captures wrapping at period
+    decoder->wrappedWidths = 1;
+#ifdef IR_DECODER_DURATIONS
+    if (decoder->durationBuffer)
+    {
+        decoder->wrappedWidths = 0;
+        pending = decodeDurationRing(decoder, maxPulses);
+    }
+    else
+#endif
+#ifdef IR_DECODER_DUAL_RING
+    if (decoder->risingBuffer)
+    {
+        pending = decodeDualRing(decoder, maxPulses);
+    }
+    else
+#endif
+#ifdef IR_DECODER_CARRIER
+    if (decoder->carrierGap)
+    {
+        pending = decodeCarrierRing(decoder, maxPulses);
+    }
+    else
+#endif
+    {
+        pending = decodeTimestampRing(decoder, maxPulses);
+    }
+    decoder->wrappedWidths = 0;
+
+    moved = decoder->currentIndex != startIndex || decoder->writeIndex != startWriteIndex;
+#ifdef IR_DECODER_DUAL_RING
+    moved |= decoder->risingIndex != startRisingIndex;
+#endif
+    if (moved)
+    {
+        decoder->quietDecodes = 0;
+    }
+    else if (decoder->quietDecodes < UINT16_MAX)
+    {
+        decoder->quietDecodes++;
+    }
+
+    return pending;
+}
+
+void IR_Decoder_DecodeTimestamps(IR_Decoder_t *decoder, const uint64_t *times, uint16_t count)
+{
+#ifdef IR_DECODER_TRACE
+    traceDecode(decoder);
+#endif
+    applyTiming(decoder);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        // monotonic timestamps need no wrap handling and long gaps stay long
+        if (decoder->hasLastEdge)
+        {
+            // floored on the absolute times so the rounding does not add up over a burst of carrier edges
+            uint64_t pulseTime = times[i] / decoder->clockSpeed - decoder->lastEdge / decoder->clockSpeed;
+
+            decoder->widthStart = decoder->lastEdge;
+            decoder->widthEnd = times[i];
+            decodeCaptured(decoder, pulseTime > UINT32_MAX ? UINT32_MAX : (uint32_t)pulseTime);
+        }
+
+        decoder->lastEdge = times[i];
+        decoder->hasLastEdge = 1;
+    }
+}
+
+#ifdef IR_DECODER_DURATIONS
+void IR_Decoder_DecodeDurations(IR_Decoder_t *decoder, const uint16_t *durations, uint16_t count)
+{
+#ifdef IR_DECODER_TRACE
+    traceDecode(decoder);
+#endif
+    applyTiming(decoder);
+    decoder->widthStart = 0;
+    decoder->widthEnd = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        checkDurationClamp(decoder, durations[i]);
+        decodeCaptured(decoder, durations[i]);
+    }
+}
+#endif
+
+#ifdef IR_DECODER_SAMPLES
+void IR_Decoder_DecodeSamples(IR_Decoder_t *decoder, const uint32_t *samples, uint16_t count, uint32_t sampleNs)
+{
+#ifdef IR_DECODER_TRACE
+    traceDecode(decoder);
+#endif
+    applyTiming(decoder);
+    decoder->widthStart = 0;
+    decoder->widthEnd = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        // bits that differ from the current level, each one found ends a run
+        uint32_t changes = decoder->sampleLevel ? ~samples[i] : samples[i];
+        uint8_t start = 0;
 
-            decoder->pulseNumber++;
+        while (changes)
+        {
+            uint8_t edge = countTrailingZeros(changes);
+            uint64_t runNs = ((uint64_t)decoder->sampleRun + edge - start) * sampleNs + decoder->sampleRemainder;
+            uint64_t pulseTime = runNs / 1000;
 
-            if (decoder->pulseNumber == MAXPULSES)
+            // the sub us part carries over so short carrier runs do not lose time
+            decoder->sampleRemainder = runNs % 1000;
+            if (pulseTime > UINT32_MAX)
             {
-                decoder->pulseNumber = 0;
-                decoder->state = AddressInv;
+                pulseTime = UINT32_MAX;
             }
 
-            break;
-        case AddressInv:
-            if (signal >= 0)
+            // the receiver output is low during a mark
+#ifdef IR_DECODER_CARRIER
+            if (decoder->carrierGap)
             {
-                decoder->message->addressInv |= signal << decoder->pulseNumber;
+                demodulate(decoder, pulseTime);
             }
             else
+#endif
             {
-                decoder->message->addressInvError |= 1 << decoder->pulseNumber;
+                decodeWidth(decoder, pulseTime, !decoder->sampleLevel);
             }
+            decoder->sampleLevel ^= 1;
+            decoder->sampleRun = 0;
+            start = edge;
+            // the same bits against the new level, the ones already counted masked off
+            changes = ~changes & (UINT32_MAX << edge);
+        }
+
+        if (decoder->sampleRun < UINT32_MAX - 32)
+        {
+            decoder->sampleRun += 32 - start;
+        }
+    }
+}
+#endif
+
+#ifdef IR_DECODER_DURATIONS
+uint16_t IR_Decoder_ToDurations(IR_Decoder_t *decoder, const uint32_t *times, uint16_t count, uint16_t *durations)
+{
+    for (uint16_t i = 1; i < count; i++)
+    {
+        uint32_t pulseTime = getPulseTime(times[i - 1], times[i], decoder->period, decoder->clockSpeed);
+
+        // anything this long is an idle gap, its exact length does not matter
+        durations[i - 1] = pulseTime > UINT16_MAX ? UINT16_MAX : pulseTime;
+    }
+
+    return count ? count - 1 : 0;
+}
+#endif
+
+uint64_t IR_Decoder_ExtendCapture(IR_Decoder_t *decoder, uint32_t capture, uint32_t overflows, uint8_t overflowPending)
+{
+    // the timer wrapped before the capture was taken but its update interrupt has not counted it yet
+    if (overflowPending && capture < decoder->period / 2)
+    {
+        overflows++;
+    }
+
+    return (uint64_t)overflows * decoder->period + capture;
+}
+
+uint8_t IR_Decoder_IsIdle(IR_Decoder_t *decoder, uint16_t decodeIntervalMs, uint16_t idleMs)
+{
+    uint32_t quietMs = (uint32_t)decoder->quietDecodes * decodeIntervalMs;
+
+    // the edge timeout only fires on the next edge, a frame cut short by interference would otherwise
+    // keep the decoder awake until one comes
+    if (decoder->state >= Address && decoder->state <= CommandInv &&
+        (uint64_t)quietMs * 1000 >= decoder->timing->edgeTimeout)
+    {
+        abandonFrame(decoder);
+    }
+
+    // nothing part way through a frame and no new edges for idleMs
+    return isSeeking(decoder) && !decoder->clearLast && quietMs >= idleMs;
+}
+
+void IR_Decoder_Resume(IR_Decoder_t *decoder)
+{
+    decoder->quietDecodes = 0;
+    IR_Decoder_Decode(decoder);
+}
 
-            decoder->pulseNumber++;
+static uint8_t decodeTimestampRing(IR_Decoder_t *decoder, uint16_t maxPulses)
+{
+    uint32_t time0;
+    uint32_t time1;
+    uint32_t time2;
+    uint32_t time3;
+    uint64_t skippedTicks = 0;
+
+    time0 = decoder->buffer[decoder->currentIndex];
+    time1 = decoder->buffer[(decoder->currentIndex + 1) % decoder->bufferSize];
+    time2 = decoder->buffer[(decoder->currentIndex + 2) % decoder->bufferSize];
+    time3 = decoder->buffer[(decoder->currentIndex + 3) % decoder->bufferSize];
+
+    while (isPulseAvailable(decoder, time0, time1, time2, time3))
+    {
+        uint32_t fallingTicks;
+        uint32_t risingTicks;
+
+        if (!maxPulses--)
+        {
+            addElapsedTicks(decoder, skippedTicks);
+            return 1;
+        }
+
+        if (decoder->hasTrailingEdge)
+        {
+            addElapsed(decoder, getPulseTime(decoder->trailingEdge, time0, decoder->period, decoder->clockSpeed));
+            decoder->hasTrailingEdge = 0;
+        }
+
+        fallingTicks = getPulseTicks(time0, time1, decoder->period);
+        risingTicks = getPulseTicks(time1, time2, decoder->period);
+
+        if (isSeeking(decoder) && !(isLeadInMark(decoder->timing, fallingTicks, decoder->clockSpeed) &&
+                                    isLeadInSpace(decoder->timing, risingTicks, decoder->clockSpeed)))
+        {
+            // hunting for a lead-in, drop edges one at a time rather than in pairs so a lost or extra
+            // edge only costs that edge, nothing is classified until a 9ms mark turns up
+            skippedTicks += fallingTicks;
+            clearCurrentIndex(decoder);
+            seekLeadIn(decoder, &maxPulses, &skippedTicks);
+        }
+        else
+        {
+            uint32_t fallingTime = fallingTicks / decoder->clockSpeed;
+            uint32_t risingTime = risingTicks / decoder->clockSpeed;
 
-            if (decoder->pulseNumber == MAXPULSES)
+            addElapsedTicks(decoder, skippedTicks);
+            skippedTicks = 0;
+
+            // the frame stopped, look for a lead-in again from this edge rather than from the next pair
+            if (checkEdgeTimeout(decoder, fallingTime, risingTime))
             {
-                decoder->pulseNumber = 0;
-                decoder->state = Command;
+                continue;
             }
-            break;
-        case Command:
-            if (signal >= 0)
+
+            decoder->markStart = time0;
+            decoder->widthEnd = time2;
+            if (decodePulseTimes(decoder, fallingTime, risingTime))
             {
-                decoder->message->command |= signal << decoder->pulseNumber;
+                // the final mark and the gap after it are skipped, time them up to the next pulse
+                decoder->trailingEdge = time2;
+                decoder->hasTrailingEdge = 1;
+                clearCurrentIndex(decoder);
+                // there is an extra rising time at the end of the signal that needs to be removed
+                clearCurrentIndex(decoder);
+                checkTrailingEdge(decoder);
             }
-            else
+
+            clearCurrentIndex(decoder);
+            clearCurrentIndex(decoder);
+        }
+
+        time0 = decoder->buffer[decoder->currentIndex];
+        time1 = decoder->buffer[(decoder->currentIndex + 1) % decoder->bufferSize];
+        time2 = decoder->buffer[(decoder->currentIndex + 2) % decoder->bufferSize];
+        time3 = decoder->buffer[(decoder->currentIndex + 3) % decoder->bufferSize];
+    }
+
+    addElapsedTicks(decoder, skippedTicks);
+    return 0;
+}
+
+static void seekLeadIn(IR_Decoder_t *decoder, uint16_t *maxPulses, uint64_t *skippedTicks)
+{
+    // skip the run of edges that cannot start a 9ms mark, a subtraction and two compares each,
+    // whatever is left is checked as a pair by the caller
+    uint32_t markLow = (decoder->timing->leadInMarkLow + 1) * decoder->clockSpeed;
+    uint32_t markHigh = decoder->timing->leadInMarkHigh * decoder->clockSpeed;
+    uint8_t available = decoder->captureRemaining ? edgesAvailable(decoder) : 0;
+    uint8_t next = decoder->currentIndex + 1 == decoder->bufferSize ? 0 : decoder->currentIndex + 1;
+    uint32_t time0 = decoder->buffer[decoder->currentIndex];
+    uint32_t time1 = decoder->buffer[next];
+
+    while (*maxPulses)
+    {
+        uint8_t after = next + 1 == decoder->bufferSize ? 0 : next + 1;
+        uint32_t time2 = decoder->buffer[after];
+        uint32_t markTicks;
+
+        // the same three edges a pair needs, empty slots end the sentinel ring
+        if (decoder->captureRemaining ? available < 3 : !(time1 && time2))
+        {
+            return;
+        }
+
+        markTicks = getPulseTicks(time0, time1, decoder->period);
+        if (markTicks >= markLow && markTicks < markHigh)
+        {
+            return;
+        }
+
+        (*maxPulses)--;
+        *skippedTicks += markTicks;
+        clearCurrentIndex(decoder);
+        available--;
+        time0 = time1;
+        time1 = time2;
+        next = after;
+    }
+}
+
+#ifdef IR_DECODER_DURATIONS
+static uint8_t decodeDurationRing(IR_Decoder_t *decoder, uint16_t maxPulses)
+{
+    // widths are consumed one at a time, no edge pairing or wrap handling
+    decoder->widthStart = 0;
+    decoder->widthEnd = 0;
+    while (edgesAvailable(decoder))
+    {
+        if (!maxPulses)
+        {
+            return 1;
+        }
+
+        checkDurationClamp(decoder, decoder->durationBuffer[decoder->currentIndex]);
+        decodeCaptured(decoder, decoder->durationBuffer[decoder->currentIndex]);
+        clearCurrentIndex(decoder);
+
+        // a pulse is done once its space has been paired with the mark
+        maxPulses -= !decoder->hasMark;
+    }
+
+    return 0;
+}
+#endif
+
+#ifdef IR_DECODER_RECORDER
+static uint8_t isTimestampRing(IR_Decoder_t *decoder)
+{
+    // the recorder only replays captures of both edges
+#ifdef IR_DECODER_DURATIONS
+    if (decoder->durationBuffer)
+    {
+        return 0;
+    }
+#endif
+#ifdef IR_DECODER_DUAL_RING
+    if (decoder->risingBuffer)
+    {
+        return 0;
+    }
+#endif
+#ifdef IR_DECODER_CARRIER
+    if (decoder->carrierGap)
+    {
+        return 0;
+    }
+#endif
+    return 1;
+}
+#endif
+
+static void publishMessage(IR_Decoder_t *decoder)
+{
+#ifdef IR_DECODER_TRACE
+    decoder->message->decodeTime = decoder->decodeTime;
+    decoder->message->callbackTime = decoder->traceTime ? decoder->traceTime() : 0;
+#endif
+    if (decoder->contextCallback)
+    {
+        decoder->contextCallback(decoder->callbackContext, decoder->message);
+    }
+    else
+    {
+        decoder->decodeCallback(decoder->message);
+    }
+}
+
+#ifdef IR_DECODER_TRACE
+static void traceDecode(IR_Decoder_t *decoder)
+{
+    decoder->decodeTime = decoder->traceTime ? decoder->traceTime() : 0;
+}
+#endif
+
+static void addElapsed(IR_Decoder_t *decoder, uint32_t pulseTime)
+{
+    // a ring width could be any number of periods longer, the time since the frame is lost
+    if (decoder->wrappedWidths)
+    {
+        decoder->sinceFrame = UINT32_MAX;
+        return;
+    }
+
+    decoder->sinceFrame = pulseTime > UINT32_MAX - decoder->sinceFrame ? UINT32_MAX : decoder->sinceFrame + pulseTime;
+}
+
+#ifdef IR_DECODER_DURATIONS
+static void checkDurationClamp(IR_Decoder_t *decoder, uint16_t duration)
+{
+    // a clamped or stopped timer only bounds the width from below
+    if (duration == UINT16_MAX)
+    {
+        decoder->sinceFrame = UINT32_MAX;
+    }
+}
+#endif
+
+static void addElapsedTicks(IR_Decoder_t *decoder, uint64_t ticks)
+{
+    uint64_t time = ticks / decoder->clockSpeed;
+
+    addElapsed(decoder, time > UINT32_MAX ? UINT32_MAX : (uint32_t)time);
+}
+
+static uint64_t placeCapture(IR_Decoder_t *decoder, uint32_t capture)
+{
+    // the capture is less than a period old, the latest time before now that it can stand for
+    uint64_t now = decoder->captureNow();
+
+    return now - (now % decoder->period + decoder->period - capture) % decoder->period;
+}
+
+static uint64_t placeEdge(IR_Decoder_t *decoder, uint64_t edge)
+{
+    // ring captures go on the caller's clock, timestamps given to DecodeTimestamps already are
+    return decoder->wrappedWidths && decoder->captureNow ? placeCapture(decoder, (uint32_t)edge) : edge;
+}
+
+static uint32_t getRingGap(IR_Decoder_t *decoder, uint64_t firstEdge)
+{
+    uint64_t ticks;
+
+    if (!decoder->captureNow || decoder->frameEnd == UINT64_MAX || firstEdge < decoder->frameEnd)
+    {
+        return UINT32_MAX;
+    }
+
+    ticks = (firstEdge - decoder->frameEnd) / decoder->clockSpeed;
+    return ticks > UINT32_MAX ? UINT32_MAX : (uint32_t)ticks;
+}
+
+static uint8_t isSeeking(IR_Decoder_t *decoder)
+{
+    return decoder->state == LeadIn || decoder->state == Resync;
+}
+
+static void applyTiming(IR_Decoder_t *decoder)
+{
+    // a new profile only between frames, widths already classified keep their meaning
+    if (isSeeking(decoder))
+    {
+        decoder->timing = decoder->nextTiming;
+    }
+}
+
+// the lead-in windows in timer ticks, the same exclusive bounds as classifyPulse on the converted time
+static uint8_t isLeadInMark(const IR_Timing_t *timing, uint32_t pulseTime, uint8_t clockSpeed)
+{
+    return pulseTime >= (uint32_t)(timing->leadInMarkLow + 1) * clockSpeed &&
+           pulseTime < (uint32_t)timing->leadInMarkHigh * clockSpeed;
+}
+
+static uint8_t isLeadInSpace(const IR_Timing_t *timing, uint32_t pulseTime, uint8_t clockSpeed)
+{
+    return (pulseTime >= (uint32_t)(timing->leadInSpaceLow + 1) * clockSpeed &&
+            pulseTime < (uint32_t)timing->leadInSpaceHigh * clockSpeed) ||
+           (pulseTime >= (uint32_t)(timing->repeatSpaceLow + 1) * clockSpeed &&
+            pulseTime < (uint32_t)timing->repeatSpaceHigh * clockSpeed);
+}
+
+static uint8_t checkEdgeTimeout(IR_Decoder_t *decoder, uint32_t fallingTime, uint32_t risingTime)
+{
+    // edges stopped mid frame, drop it
+    if (decoder->state >= Address && decoder->state <= CommandInv &&
+        (fallingTime >= decoder->timing->edgeTimeout || risingTime >= decoder->timing->edgeTimeout))
+    {
+        abandonFrame(decoder);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void abandonFrame(IR_Decoder_t *decoder)
+{
+    IR_PROBE3(state, decoder, decoder->state, Resync);
+    decoder->state = Resync;
+    decoder->pulseNumber = 0;
+    decoder->timeouts++;
+    applyTiming(decoder);
+}
+
+static uint8_t isDuplicate(IR_Decoder_t *decoder)
+{
+    return decoder->duplicateWindow && !decoder->frameError && decoder->frame == decoder->lastFrame &&
+           decoder->leadInGap < decoder->duplicateWindow;
+}
+
+#ifdef IR_DECODER_QUALITY
+static void addDeviation(IR_Decoder_t *decoder, uint32_t pulseTime, uint32_t nominal)
+{
+    uint32_t deviation = pulseTime > nominal ? pulseTime - nominal : nominal - pulseTime;
+
+    // clamped so a whole frame of deviations fits the sum
+    deviation = deviation > UINT16_MAX ? UINT16_MAX : deviation;
+    decoder->deviationSum += deviation;
+    decoder->deviationMax = deviation > decoder->deviationMax ? deviation : decoder->deviationMax;
+}
+
+static void addBitDeviation(IR_Decoder_t *decoder, uint32_t fallingTime, uint32_t risingTime)
+{
+    uint32_t shortPulse = (decoder->timing->shortLow + decoder->timing->shortHigh) / 2;
+    uint32_t longPulse = (decoder->timing->longLow + decoder->timing->longHigh) / 2;
+
+    // spaces are measured against the nearer nominal so bad bits still count
+    addDeviation(decoder, fallingTime, shortPulse);
+    addDeviation(decoder, risingTime, risingTime >= (shortPulse + longPulse) / 2 ? longPulse : shortPulse);
+}
+#endif
+
+static uint8_t decodePulseTimes(IR_Decoder_t *decoder, uint32_t fallingTime, uint32_t risingTime)
+{
+    uint8_t signal = decodePulse(decoder->timing, fallingTime, risingTime);
+    uint32_t gap = decoder->sinceFrame;
+
+    addElapsed(decoder, fallingTime);
+    addElapsed(decoder, risingTime);
+
+    switch (decoder->state)
+    {
+    case LeadIn:
+    case Resync:
+        if (signal == SymbolHeader)
+        {
+            uint64_t firstEdge = placeEdge(decoder, decoder->markStart);
+
+            // the ring widths only count the gap modulo period
+            if (decoder->wrappedWidths)
             {
-                decoder->message->commandError |= 1 << decoder->pulseNumber;
+                gap = getRingGap(decoder, firstEdge);
             }
+            IR_PROBE2(lead_in, decoder, gap);
+            IR_PROBE3(state, decoder, decoder->state, Address);
+            decoder->state = Address;
+            decoder->leadInGap = gap;
+
+            // clear message buffer for new message
+            clearMessage(decoder->message);
+            decoder->message->firstEdge = firstEdge;
+            decoder->frame = 0;
+            decoder->frameError = 0;
+#ifdef IR_DECODER_QUALITY
+            decoder->deviationSum = 0;
+            decoder->deviationMax = 0;
+            // nominal is the middle of the active profile's window
+            addDeviation(decoder, fallingTime, (decoder->timing->leadInMarkLow + decoder->timing->leadInMarkHigh) / 2);
+            addDeviation(decoder, risingTime,
+                         (decoder->timing->leadInSpaceLow + decoder->timing->leadInSpaceHigh) / 2);
+#endif
+        }
+        // a repeat cannot refer to a frame lost in an overrun
+        else if (signal == SymbolRepeat && decoder->state == LeadIn)
+        {
+            decoder->message->repeat++;
+            IR_PROBE2(repeat, decoder, decoder->message->repeat);
+            decoder->message->firstEdge = placeEdge(decoder, decoder->markStart);
+            decoder->message->lastEdge = placeEdge(decoder, decoder->widthEnd);
+            publishMessage(decoder);
+            applyTiming(decoder);
+            return 1;
+        }
+        break;
+    case Address:
+    case AddressInv:
+    case Command:
+    case CommandInv:
+        // bits arrive LSB first, the whole frame is accumulated in one word
+        decoder->frame |= (uint32_t)(signal == SymbolOne) << decoder->pulseNumber;
+        decoder->frameError |= (uint32_t)(signal > SymbolOne) << decoder->pulseNumber;
+        if (signal > SymbolOne)
+        {
+            IR_PROBE4(bit_error, decoder, decoder->pulseNumber, fallingTime, risingTime);
+        }
+#ifdef IR_DECODER_QUALITY
+        addBitDeviation(decoder, fallingTime, risingTime);
+#endif
 
-            decoder->pulseNumber++;
+        decoder->pulseNumber++;
+        // a new byte every 8 bits, the last one ends back in LeadIn below
+        if (!(decoder->pulseNumber & 7) && decoder->pulseNumber < MAXPULSES)
+        {
+            IR_PROBE3(state, decoder, decoder->state, Address + (decoder->pulseNumber >> 3));
+        }
+        decoder->state = (DecoderState)(Address + (decoder->pulseNumber >> 3));
 
-            if (decoder->pulseNumber == MAXPULSES)
+        if (decoder->pulseNumber == MAXPULSES)
+        {
+            extractMessage(decoder);
+            decoder->message->lastEdge = placeEdge(decoder, decoder->widthEnd);
+#ifdef IR_DECODER_QUALITY
+            // the lead-in and 32 bits, a mark and a space each
+            decoder->message->meanDeviation = decoder->deviationSum / (2 * (MAXPULSES + 1));
+            decoder->message->maxDeviation = decoder->deviationMax;
+#endif
+            decoder->sinceFrame = 0;
+            decoder->frameEnd = decoder->wrappedWidths && decoder->captureNow ? decoder->message->lastEdge :
+                                UINT64_MAX;
+            IR_PROBE3(frame, decoder, decoder->frame, decoder->frameError);
+            if (isDuplicate(decoder))
             {
-                decoder->pulseNumber = 0;
-                decoder->state = CommandInv;
+                decoder->duplicates++;
             }
-            break;
-        case CommandInv:
-            if (signal >= 0)
+            else
             {
-                decoder->message->commandInv |= signal << decoder->pulseNumber;
+                publishMessage(decoder);
             }
-            else
+            if (!decoder->frameError)
             {
-                decoder->message->commandInvError |= 1 << decoder->pulseNumber;
+                decoder->lastFrame = decoder->frame;
             }
+            decoder->pulseNumber = 0;
+            IR_PROBE3(state, decoder, CommandInv, LeadIn);
+            decoder->state = LeadIn;
+            applyTiming(decoder);
+            return 1;
+        }
+        break;
+    default:
+    }
 
-            decoder->pulseNumber++;
+    return 0;
+}
 
-            if (decoder->pulseNumber == MAXPULSES)
-            {
-                decoder->decodeCallback(decoder->message);
-                decoder->pulseNumber = 0;
-                decoder->state = LeadIn;
-                clearCurrentIndex(decoder);
-                // there is an extra rising time at the end of the signal that needs to be removed
-                clearCurrentIndex(decoder);
-                // checking if the extra element is empty and setting a flag to erase it next decode call
-                if (decoder->buffer[(decoder->currentIndex + 1) % decoder->bufferSize] == 0)
-                {
-                    decoder->clearLast = 1;
-                }
-            }
-            break;
-        default:
+static void decodePulseTime(IR_Decoder_t *decoder, uint32_t pulseTime)
+{
+    // marks and spaces alternate, a pair is decoded once the space is known
+    if (!decoder->hasMark)
+    {
+        if (isSeeking(decoder) && !isLeadInMark(decoder->timing, pulseTime, 1))
+        {
+            // hunting for a lead-in, anything else is noise
+            addElapsed(decoder, pulseTime);
+            return;
         }
 
-        clearCurrentIndex(decoder);
+        decoder->markTime = pulseTime;
+        decoder->markStart = decoder->widthStart;
+        decoder->hasMark = 1;
+        return;
+    }
+
+    // the frame stopped, look for a lead-in again from its last mark
+    checkEdgeTimeout(decoder, decoder->markTime, pulseTime);
+
+    if (isSeeking(decoder) &&
+        !(isLeadInMark(decoder->timing, decoder->markTime, 1) && isLeadInSpace(decoder->timing, pulseTime, 1)))
+    {
+        // not a lead-in, move on by one width so a lost or extra edge realigns
+        addElapsed(decoder, decoder->markTime);
+        decoder->hasMark = 0;
+        decodePulseTime(decoder, pulseTime);
+        return;
+    }
+
+    decoder->hasMark = 0;
+    decodePulseTimes(decoder, decoder->markTime, pulseTime);
+}
+
+#ifdef IR_DECODER_DUAL_RING
+static uint8_t decodeDualRing(IR_Decoder_t *decoder, uint16_t maxPulses)
+{
+    // the falling and rising rings are merged on the fly, the next edge is the head that comes
+    // sooner after the last one which also orders them across the timer wrap
+    uint8_t falling = edgesAvailable(decoder);
+    uint8_t rising = (decoder->risingWriteIndex + decoder->bufferSize - decoder->risingIndex) % decoder->bufferSize;
+
+    while (falling || rising)
+    {
+        uint32_t fallingTime = decoder->buffer[decoder->currentIndex];
+        uint32_t risingTime = decoder->risingBuffer[decoder->risingIndex];
+        uint8_t isRising;
+
+        if (!maxPulses)
+        {
+            return 1;
+        }
+
+        // the very first edge is taken from the falling ring
+        if (falling && rising && decoder->hasLastEdge)
+        {
+            isRising = getPulseTicks((uint32_t)decoder->lastEdge, risingTime, decoder->period) <
+                       getPulseTicks((uint32_t)decoder->lastEdge, fallingTime, decoder->period);
+        }
+        else
+        {
+            isRising = !falling;
+        }
+
+        if (isRising)
+        {
+            decodeEdge(decoder, risingTime, 1);
+            clearRisingIndex(decoder);
+            rising--;
+        }
+        else
+        {
+            decodeEdge(decoder, fallingTime, 0);
+            clearCurrentIndex(decoder);
+            falling--;
+        }
+
+        // a pulse is done once its space has been paired with the mark
+        maxPulses -= !decoder->hasMark;
+    }
+
+    return 0;
+}
+
+static void decodeEdge(IR_Decoder_t *decoder, uint32_t time, uint8_t rising)
+{
+    uint32_t pulseTime = getEdgeTime((uint32_t)decoder->lastEdge, time, decoder->period, decoder->clockSpeed);
+    uint8_t hadEdge = decoder->hasLastEdge;
+
+    decoder->widthStart = decoder->lastEdge;
+    decoder->widthEnd = time;
+    decoder->lastEdge = time;
+    decoder->hasLastEdge = 1;
+#ifdef IR_DECODER_CARRIER
+    if (hadEdge && decoder->carrierGap)
+    {
+        demodulate(decoder, pulseTime);
+    }
+    else
+#endif
+    if (hadEdge)
+    {
+        // a width ending on a rising edge is a mark
+        decodeWidth(decoder, pulseTime, rising);
+    }
+}
+#endif
+
+#if defined(IR_DECODER_DUAL_RING) || defined(IR_DECODER_SAMPLES) || defined(IR_DECODER_CARRIER)
+static void decodeWidth(IR_Decoder_t *decoder, uint32_t pulseTime, uint8_t mark)
+{
+    // the level is known, two of a kind in a row mean an edge was lost
+    if (mark == decoder->hasMark)
+    {
+        if (!mark)
+        {
+            addElapsed(decoder, pulseTime);
+            return;
+        }
+
+        addElapsed(decoder, decoder->markTime);
+        decoder->hasMark = 0;
+    }
+
+    decodePulseTime(decoder, pulseTime);
+}
+#endif
+
+static void decodeCaptured(IR_Decoder_t *decoder, uint32_t pulseTime)
+{
+#ifdef IR_DECODER_CARRIER
+    if (decoder->carrierGap)
+    {
+        demodulate(decoder, pulseTime);
+    }
+    else
+#endif
+    {
+        decodePulseTime(decoder, pulseTime);
+    }
+}
+
+#ifdef IR_DECODER_CARRIER
+static void demodulate(IR_Decoder_t *decoder, uint32_t pulseTime)
+{
+    // carrier cycles are far shorter than carrierGap, a run of them is one mark
+    if (pulseTime < decoder->carrierGap)
+    {
+        if (!decoder->carrierBurst)
+        {
+            decoder->carrierStart = decoder->widthStart;
+        }
+        decoder->carrierBurst = pulseTime > UINT32_MAX - decoder->carrierBurst ? UINT32_MAX :
+                                decoder->carrierBurst + pulseTime;
+        decoder->carrierOff = decoder->carrierLast;
+        decoder->carrierLast = pulseTime;
+        return;
+    }
+
+    // the burst ends on the edge that turns the last cycle off, its off half belongs to the mark
+    if (decoder->carrierBurst)
+    {
+        uint32_t off = decoder->carrierOff < pulseTime ? decoder->carrierOff : 0;
+
+        decoder->widthStart = decoder->carrierStart;
+        decodeWidth(decoder, decoder->carrierBurst + off, 1);
+        pulseTime -= off;
+        decoder->carrierBurst = 0;
+        decoder->carrierOff = 0;
+        decoder->carrierLast = 0;
+    }
+
+    decodeWidth(decoder, pulseTime, 0);
+}
+
+static uint8_t decodeCarrierRing(IR_Decoder_t *decoder, uint16_t maxPulses)
+{
+    // every edge of the carrier is a width of its own, no pairing or trailing edge handling; without a
+    // DMA write position the new captures are the non-zero ones, each cleared as it is read
+    uint8_t available = edgesAvailable(decoder);
+
+    while (decoder->captureRemaining ? available-- != 0 : decoder->buffer[decoder->currentIndex] != 0)
+    {
+        uint32_t time = decoder->buffer[decoder->currentIndex];
+
+        if (!maxPulses)
+        {
+            return 1;
+        }
+
+        if (decoder->hasLastEdge)
+        {
+            decoder->widthStart = decoder->lastEdge;
+            decoder->widthEnd = time;
+            demodulate(decoder, getEdgeTime((uint32_t)decoder->lastEdge, time, decoder->period, decoder->clockSpeed));
+        }
+        decoder->lastEdge = time;
+        decoder->hasLastEdge = 1;
         clearCurrentIndex(decoder);
 
-        time0 = decoder->buffer[decoder->currentIndex];
-        time1 = decoder->buffer[(decoder->currentIndex + 1) % decoder->bufferSize];
-        time2 = decoder->buffer[(decoder->currentIndex + 2) % decoder->bufferSize];
-        time3 = decoder->buffer[(decoder->currentIndex + 3) % decoder->bufferSize];
+        // a pulse is done once its space has been paired with the mark
+        maxPulses -= !decoder->hasMark && !decoder->carrierBurst;
     }
+
+    return 0;
 }
+#endif
+
+#ifdef IR_DECODER_SAMPLES
+static uint8_t countTrailingZeros(uint32_t value)
+{
+#if defined(__GNUC__)
+    // RBIT and CLZ on Cortex-M3 and up
+    return __builtin_ctz(value);
+#else
+    uint8_t count = 0;
+
+    while (!(value & 1))
+    {
+        value >>= 1;
+        count++;
+    }
 
+    return count;
+#endif
+}
+#endif
+
+#ifdef IR_DECODER_DUAL_RING
+static void clearRisingIndex(IR_Decoder_t *decoder)
+{
+    decoder->risingIndex++;
+    if (decoder->risingIndex == decoder->bufferSize)
+    {
+        decoder->risingIndex = 0;
+        decoder->risingReadWraps++;
+    }
+}
+
+static int32_t risingLag(IR_Decoder_t *decoder, uint16_t wraps)
+{
+    int32_t lag = (int32_t)(uint16_t)(wraps - decoder->risingReadWraps) * decoder->bufferSize +
+                  decoder->risingWriteIndex - decoder->risingIndex;
+
+    // the DMA reloaded but its transfer complete interrupt has not run yet
+    if (lag < 0)
+    {
+        lag += decoder->bufferSize;
+    }
+
+    return lag;
+}
+
+static void recoverDualOverrun(IR_Decoder_t *decoder, uint16_t wraps, uint16_t risingWraps)
+{
+    // the rings cannot be cut at the same point in time by a count, drop everything unread in both
+    uint32_t index = decoder->currentIndex + captureLag(decoder, wraps);
+    uint32_t risingIndex = decoder->risingIndex + risingLag(decoder, risingWraps);
+
+    decoder->readWraps += index / decoder->bufferSize;
+    decoder->currentIndex = index % decoder->bufferSize;
+    decoder->risingReadWraps += risingIndex / decoder->bufferSize;
+    decoder->risingIndex = risingIndex % decoder->bufferSize;
+
+    // resync on the next lead-in
+    IR_PROBE3(state, decoder, decoder->state, Resync);
+    decoder->state = Resync;
+    decoder->pulseNumber = 0;
+    decoder->hasLastEdge = 0;
+    decoder->hasMark = 0;
+    decoder->sinceFrame = UINT32_MAX;
+    decoder->frameEnd = UINT64_MAX;
+    decoder->overruns++;
+}
+#endif
 
 static uint8_t areTimestampsValid(uint32_t time0, uint32_t time1, uint32_t time2, uint32_t time3)
 {
@@ -178,10 +1373,95 @@ static uint8_t areTimestampsValid(uint32_t time0, uint32_t time1, uint32_t time2
            (time0 > 0 && time1 > 0 && time1 > time3 && time3 > 0);
 }
 
+static uint8_t isPulseAvailable(IR_Decoder_t *decoder, uint32_t time0, uint32_t time1, uint32_t time2, uint32_t time3)
+{
+    if (decoder->captureRemaining)
+    {
+        return edgesAvailable(decoder) >= 3;
+    }
+
+    return areTimestampsValid(time0, time1, time2, time3);
+}
+
+static uint8_t edgesAvailable(IR_Decoder_t *decoder)
+{
+    // currentIndex is one past the write position until the skipped trailing edge arrives
+    if (decoder->clearLast)
+    {
+        return 0;
+    }
+
+    return (decoder->writeIndex + decoder->bufferSize - decoder->currentIndex) % decoder->bufferSize;
+}
+
+static int32_t captureLag(IR_Decoder_t *decoder, uint16_t wraps)
+{
+    int32_t lag = (int32_t)(uint16_t)(wraps - decoder->readWraps) * decoder->bufferSize +
+                  decoder->writeIndex - decoder->currentIndex;
+
+    // the DMA reloaded but its transfer complete interrupt has not run yet
+    if (lag < 0 && !decoder->clearLast)
+    {
+        lag += decoder->bufferSize;
+    }
+
+    return lag;
+}
+
+static uint8_t isCaptureOverrun(IR_Decoder_t *decoder, uint16_t wraps)
+{
+    // a full ring is treated as lapped, the next transfer overwrites currentIndex
+    return captureLag(decoder, wraps) >= decoder->bufferSize;
+}
+
+static void recoverOverrun(IR_Decoder_t *decoder, uint16_t wraps)
+{
+    // keep the newest half of the ring, the resync seeks the lead-in edge by edge so any edge will do
+    uint32_t discard = captureLag(decoder, wraps) - decoder->bufferSize / 2;
+    uint32_t index;
+
+    index = decoder->currentIndex + discard;
+    decoder->readWraps += index / decoder->bufferSize;
+    decoder->currentIndex = index % decoder->bufferSize;
+
+    // any frame in progress lost edges, resync on the next lead-in
+    IR_PROBE3(state, decoder, decoder->state, Resync);
+    decoder->state = Resync;
+    decoder->pulseNumber = 0;
+    decoder->clearLast = 0;
+    decoder->sinceFrame = UINT32_MAX;
+    decoder->frameEnd = UINT64_MAX;
+    decoder->hasTrailingEdge = 0;
+    decoder->hasLastEdge = 0;
+#ifdef IR_DECODER_CARRIER
+    decoder->carrierBurst = 0;
+#endif
+    decoder->overruns++;
+}
+
+static void checkTrailingEdge(IR_Decoder_t *decoder)
+{
+    // checking if the extra element is empty and setting a flag to erase it next decode call
+    if (decoder->captureRemaining ? edgesAvailable(decoder) < 2 :
+        decoder->buffer[(decoder->currentIndex + 1) % decoder->bufferSize] == 0)
+    {
+        decoder->clearLast = 1;
+    }
+}
+
 static void clearCurrentIndex(IR_Decoder_t *decoder)
 {
-        decoder->buffer[decoder->currentIndex] = 0;
-        decoder->currentIndex = (decoder->currentIndex + 1) % decoder->bufferSize;
+        // with a DMA write position the buffer is left untouched
+        if (!decoder->captureRemaining)
+        {
+            decoder->buffer[decoder->currentIndex] = 0;
+        }
+        decoder->currentIndex++;
+        if (decoder->currentIndex == decoder->bufferSize)
+        {
+            decoder->currentIndex = 0;
+            decoder->readWraps++;
+        }
 }
 
 static void clearMessage(IR_Message_t* message)
@@ -195,26 +1475,73 @@ static void clearMessage(IR_Message_t* message)
     message->addressInvError = 0;
     message->commandError = 0;
     message->commandInvError = 0;
+#ifdef IR_DECODER_QUALITY
+    message->meanDeviation = 0;
+    message->maxDeviation = 0;
+#endif
+    message->firstEdge = 0;
+    message->lastEdge = 0;
+#ifdef IR_DECODER_TRACE
+    message->decodeTime = 0;
+    message->callbackTime = 0;
+#endif
+}
+
+static void extractMessage(IR_Decoder_t *decoder)
+{
+    decoder->message->address = decoder->frame;
+    decoder->message->addressInv = decoder->frame >> 8;
+    decoder->message->command = decoder->frame >> 16;
+    decoder->message->commandInv = decoder->frame >> 24;
+    decoder->message->addressError = decoder->frameError;
+    decoder->message->addressInvError = decoder->frameError >> 8;
+    decoder->message->commandError = decoder->frameError >> 16;
+    decoder->message->commandInvError = decoder->frameError >> 24;
 }
 
 static uint32_t getPulseTime(uint32_t time0, uint32_t time1, uint32_t period, uint8_t clockSpeed)
 {
-    return time0 > time1 ? (period - time0 + time1) / clockSpeed : (time1 - time0) / clockSpeed;
+    return getPulseTicks(time0, time1, period) / clockSpeed;
+}
+
+#if defined(IR_DECODER_DUAL_RING) || defined(IR_DECODER_CARRIER)
+static uint32_t getEdgeTime(uint32_t time0, uint32_t time1, uint32_t period, uint8_t clockSpeed)
+{
+    // the difference of the floored times, the rounding of a run of widths cancels out
+    return time0 > time1 ? period / clockSpeed - time0 / clockSpeed + time1 / clockSpeed :
+                           time1 / clockSpeed - time0 / clockSpeed;
+}
+#endif
+
+static uint32_t getPulseTicks(uint32_t time0, uint32_t time1, uint32_t period)
+{
+    return time0 > time1 ? period - time0 + time1 : time1 - time0;
 }
 
-static int8_t decodePulse(uint32_t fallingTime, uint32_t risingTime)
+static uint8_t classifyPulse(const IR_Timing_t *timing, uint32_t pulseTime)
 {
-    if (fallingTime < SHORTPULSE_HIGHBOUND && fallingTime > SHORTPULSE_LOWBOUND)
+    uint32_t bucket = pulseTime >> IR_TIMING_BUCKET_SHIFT;
+    uint8_t entry;
+
+    if (bucket >= IR_TIMING_BUCKETS)
     {
-        if (risingTime < LONGPULSE_HIGHBOUND && risingTime > LONGPULSE_LOWBOUND)
-        {
-            return 1;
-        }
-        else if (risingTime < SHORTPULSE_HIGHBOUND && risingTime > SHORTPULSE_LOWBOUND)
+        return PulseNone;
+    }
+
+    entry = timing->classTable[bucket];
+    if (entry & PULSE_PARTIAL)
+    {
+        entry &= ~PULSE_PARTIAL;
+        if (pulseTime <= timing->lowBound[entry] || pulseTime >= timing->highBound[entry])
         {
-            return 0;
+            return PulseNone;
         }
     }
 
-    return -1;
+    return entry;
+}
+
+static uint8_t decodePulse(const IR_Timing_t *timing, uint32_t fallingTime, uint32_t risingTime)
+{
+    return pulseSymbol[classifyPulse(timing, fallingTime)][classifyPulse(timing, risingTime)];
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "IR_Encoder.h"
+#include "IR_Timing.h"
+
+#define FRAMEBITS 32
+
+static uint8_t encodeFrame(IR_Encoder_t *encoder, uint32_t frame, uint32_t *buffer);
+static uint32_t addPulseTime(IR_Encoder_t *encoder, uint32_t time, uint32_t pulseTime);
+
+void IR_Encoder_Init(IR_Encoder_t *encoder, uint32_t start)
+{
+    encoder->time = start % encoder->period;
+}
+
+uint8_t IR_Encoder_Frame(IR_Encoder_t *encoder, uint8_t address, uint8_t command, uint32_t *buffer)
+{
+    uint8_t addressInv = ~address;
+    uint8_t commandInv = ~command;
+
+    return encodeFrame(encoder, address | addressInv << 8 | (uint32_t)command << 16 | (uint32_t)commandInv << 24, buffer);
+}
+
+uint8_t IR_Encoder_Message(IR_Encoder_t *encoder, const IR_Message_t *message, uint32_t *buffer)
+{
+    return encodeFrame(encoder, message->address | message->addressInv << 8 |
+                       (uint32_t)message->command << 16 | (uint32_t)message->commandInv << 24, buffer);
+}
+
+uint8_t IR_Encoder_Repeat(IR_Encoder_t *encoder, uint32_t *buffer)
+{
+    uint32_t time = encoder->time;
+
+    buffer[0] = time;
+    buffer[1] = time = addPulseTime(encoder, time, LEADIN_LOWPULSE);
+    buffer[2] = time = addPulseTime(encoder, time, REPEAT_HIGHPULSE);
+    buffer[3] = addPulseTime(encoder, time, SHORTPULSE);
+
+    encoder->time = addPulseTime(encoder, encoder->time, FRAME_PERIOD);
+
+    return IR_ENCODER_REPEAT_EDGES;
+}
+
+static uint8_t encodeFrame(IR_Encoder_t *encoder, uint32_t frame, uint32_t *buffer)
+{
+    uint32_t time = encoder->time;
+    uint8_t index = 0;
+
+    // falling edge starts each mark, rising edge ends it
+    buffer[index++] = time;
+    buffer[index++] = time = addPulseTime(encoder, time, LEADIN_LOWPULSE);
+    buffer[index++] = time = addPulseTime(encoder, time, LEADIN_HIGHPULSE);
+
+    // LSB first, each bit is a short mark followed by a short or long space
+    for (uint8_t pulseNumber = 0; pulseNumber < FRAMEBITS; pulseNumber++)
+    {
+        buffer[index++] = time = addPulseTime(encoder, time, SHORTPULSE);
+        buffer[index++] = time = addPulseTime(encoder, time, (frame >> pulseNumber) & 1 ? LONGPULSE : SHORTPULSE);
+    }
+
+    // stop mark
+    buffer[index++] = addPulseTime(encoder, time, SHORTPULSE);
+
+    encoder->time = addPulseTime(encoder, encoder->time, FRAME_PERIOD);
+
+    return index;
+}
+
+static uint32_t addPulseTime(IR_Encoder_t *encoder, uint32_t time, uint32_t pulseTime)
+{
+    uint32_t ticks = pulseTime * encoder->clockSpeed % encoder->period;
+
+    // a free running 32 bit timer has a period near 2^32, time + ticks would overflow before the wrap
+    return time >= encoder->period - ticks ? time - (encoder->period - ticks) : time + ticks;
+}
@@ -0,0 +1,250 @@
+#include "IR_Recorder.h"
+
+#include <stddef.h>
+
+static uint8_t writeVarint(IR_Recorder_t *recorder, uint32_t value);
+static uint8_t readVarint(IR_Replay_t *replay, uint32_t *value);
+static uint32_t replayRemaining(void);
+static void replayWrite(IR_Replay_t *replay, uint32_t time);
+
+// the fake NDTR only knows about one replay
+static IR_Replay_t *activeReplay;
+
+void IR_Recorder_Init(IR_Recorder_t *recorder, uint8_t *trace, uint32_t size)
+{
+    recorder->trace = trace;
+    recorder->size = size;
+    recorder->length = 0;
+    recorder->full = 0;
+    recorder->index = 0;
+    recorder->wraps = 0;
+    recorder->lastEdge = 0;
+}
+
+void IR_Recorder_Start(IR_Recorder_t *recorder, IR_Decoder_t *decoder)
+{
+    recorder->length = 0;
+    recorder->full = recorder->size < IR_RECORDER_HEADER_SIZE;
+    recorder->index = 0;
+    recorder->wraps = 0;
+    recorder->lastEdge = 0;
+
+    if (recorder->full)
+    {
+        return;
+    }
+
+    recorder->trace[0] = 'I';
+    recorder->trace[1] = 'R';
+    recorder->trace[2] = 'T';
+    recorder->trace[3] = IR_RECORDER_VERSION;
+    recorder->trace[4] = decoder->captureRemaining ? IR_RECORDER_FLAG_DMA : 0;
+    recorder->trace[5] = decoder->bufferSize;
+    recorder->trace[6] = decoder->clockSpeed;
+    recorder->trace[7] = 0;
+    recorder->trace[8] = decoder->period;
+    recorder->trace[9] = decoder->period >> 8;
+    recorder->trace[10] = decoder->period >> 16;
+    recorder->trace[11] = decoder->period >> 24;
+    recorder->length = IR_RECORDER_HEADER_SIZE;
+}
+
+void IR_Recorder_Decode(IR_Recorder_t *recorder, IR_Decoder_t *decoder, uint16_t wraps)
+{
+    uint32_t start = recorder->length;
+    uint32_t lastEdge = recorder->lastEdge;
+    uint32_t written;
+    uint32_t skipped = 0;
+    uint8_t ok;
+
+    if (recorder->full)
+    {
+        return;
+    }
+
+    if (decoder->captureRemaining)
+    {
+        // everything the DMA wrote since the last call, of which at most a ring survives
+        written = (uint32_t)(uint16_t)(wraps - recorder->wraps) * decoder->bufferSize +
+                  decoder->writeIndex - recorder->index;
+        if (written > decoder->bufferSize)
+        {
+            skipped = written - decoder->bufferSize;
+            written = decoder->bufferSize;
+        }
+    }
+    else
+    {
+        // edges recorded last call that the decoder has not consumed yet
+        uint8_t pending = (recorder->index + decoder->bufferSize - decoder->currentIndex) % decoder->bufferSize;
+        uint8_t slot = recorder->index;
+
+        // currentIndex skipped the trailing edge of the last frame, it is the next slot to record
+        if (decoder->clearLast && pending == decoder->bufferSize - 1)
+        {
+            pending = 0;
+        }
+
+        written = 0;
+        while (written + pending < decoder->bufferSize && decoder->buffer[slot])
+        {
+            written++;
+            slot = (slot + 1) % decoder->bufferSize;
+        }
+    }
+
+    ok = writeVarint(recorder, recorder->getTime ? recorder->getTime() : 0) &&
+         writeVarint(recorder, skipped) &&
+         writeVarint(recorder, written);
+
+    recorder->index = (recorder->index + skipped % decoder->bufferSize) % decoder->bufferSize;
+    for (uint32_t i = 0; ok && i < written; i++)
+    {
+        uint32_t edge = decoder->buffer[recorder->index];
+        int32_t delta = (int32_t)(edge - recorder->lastEdge);
+
+        ok = writeVarint(recorder, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+        recorder->lastEdge = edge;
+        recorder->index = (recorder->index + 1) % decoder->bufferSize;
+    }
+
+    if (!ok)
+    {
+        // keep the trace consistent up to the last complete call
+        recorder->length = start;
+        recorder->lastEdge = lastEdge;
+        recorder->full = 1;
+    }
+
+    recorder->wraps = wraps;
+}
+
+uint8_t IR_Replay_Init(IR_Replay_t *replay, const uint8_t *trace, uint32_t length, IR_Decoder_t *decoder)
+{
+    uint32_t *buffer = decoder->buffer;
+    IR_Message_t *message = decoder->message;
+    void (*decodeCallback)(IR_Message_t*) = decoder->decodeCallback;
+    uint32_t period;
+
+    if (length < IR_RECORDER_HEADER_SIZE || trace[0] != 'I' || trace[1] != 'R' || trace[2] != 'T' ||
+        trace[3] != IR_RECORDER_VERSION || trace[5] < 4)
+    {
+        return 0;
+    }
+
+    // every width is divided by the clock and wrapped at the period, a corrupt header would divide by zero
+    period = (uint32_t)trace[8] | (uint32_t)trace[9] << 8 | (uint32_t)trace[10] << 16 | (uint32_t)trace[11] << 24;
+    if (!trace[6] || !period)
+    {
+        return 0;
+    }
+
+    replay->trace = trace;
+    replay->length = length;
+    replay->position = IR_RECORDER_HEADER_SIZE;
+    replay->lastEdge = 0;
+    replay->index = 0;
+    replay->decoder = decoder;
+    activeReplay = replay;
+
+    // only what the trace records, every other option off
+    IR_Decoder_ConfigDefaults(decoder);
+    decoder->buffer = buffer;
+    decoder->message = message;
+    decoder->decodeCallback = decodeCallback;
+    decoder->bufferSize = trace[5];
+    decoder->clockSpeed = trace[6];
+    decoder->period = period;
+    decoder->captureRemaining = trace[4] & IR_RECORDER_FLAG_DMA ? &replayRemaining : NULL;
+    IR_Decoder_Init(decoder);
+
+    return 1;
+}
+
+uint8_t IR_Replay_Next(IR_Replay_t *replay, uint32_t *callTime)
+{
+    uint32_t skipped;
+    uint32_t count;
+
+    if (!readVarint(replay, callTime) || !readVarint(replay, &skipped) || !readVarint(replay, &count))
+    {
+        return 0;
+    }
+
+    // lost edges only move the write position, their values were overwritten
+    while (skipped--)
+    {
+        replayWrite(replay, 0);
+    }
+
+    while (count--)
+    {
+        uint32_t zigzag;
+
+        if (!readVarint(replay, &zigzag))
+        {
+            return 0;
+        }
+
+        replay->lastEdge += (zigzag >> 1) ^ -(zigzag & 1);
+        replayWrite(replay, replay->lastEdge);
+    }
+
+    return 1;
+}
+
+static uint8_t writeVarint(IR_Recorder_t *recorder, uint32_t value)
+{
+    do
+    {
+        if (recorder->length == recorder->size)
+        {
+            return 0;
+        }
+
+        recorder->trace[recorder->length++] = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+        value >>= 7;
+    } while (value);
+
+    return 1;
+}
+
+static uint8_t readVarint(IR_Replay_t *replay, uint32_t *value)
+{
+    *value = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7)
+    {
+        uint8_t byte;
+
+        if (replay->position == replay->length)
+        {
+            return 0;
+        }
+
+        byte = replay->trace[replay->position++];
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static uint32_t replayRemaining(void)
+{
+    return activeReplay->decoder->bufferSize - activeReplay->index;
+}
+
+static void replayWrite(IR_Replay_t *replay, uint32_t time)
+{
+    replay->decoder->buffer[replay->index] = time;
+    replay->index = (replay->index + 1) % replay->decoder->bufferSize;
+
+    if (!replay->index && replay->decoder->captureRemaining)
+    {
+        IR_Decoder_CaptureWrapped(replay->decoder);
+    }
+}
@@ -0,0 +1,396 @@
+extern "C"
+{
+#include "IR_Combiner.h"
+#include "IR_Decoder.h"
+#include "IR_Encoder.h"
+#include "IR_Generator.h"
+
+#include <string.h>
+}
+
+#include "CppUTest/TestHarness.h"
+
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+#define WINDOW_US       2000
+#define MAX_DELIVERED   16
+
+static IR_Combiner_t combiner;
+static IR_Message_t delivered[MAX_DELIVERED];
+static uint8_t deliveredCount;
+static uint32_t clockTime;
+
+// a decoder interrupt that fires while the main loop handles a frame, held off while masked
+static uint8_t interruptArmed;
+static uint8_t interruptHeld;
+static uint8_t masked;
+
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint32_t fakeClock(void);
+static void raiseInterrupt(void);
+static uint32_t fakeLock(void);
+static void fakeUnlock(uint32_t state);
+static void report(uint8_t address, uint8_t command, uint32_t errors);
+static void reportFrame(uint32_t frame, uint32_t errors);
+static uint16_t frameTimestamps(uint64_t start, uint8_t command, uint8_t badBit, uint64_t *times);
+
+TEST_GROUP(IR_Combiner)
+{
+    void setup()
+    {
+        deliveredCount = 0;
+        clockTime = 1000;
+        interruptArmed = 0;
+        interruptHeld = 0;
+        masked = 0;
+        memset(delivered, 0, sizeof(delivered));
+        IR_Combiner_Init(&combiner, WINDOW_US, &fakeClock, &decodeFinished_callback);
+    }
+};
+
+TEST(IR_Combiner, CleanFrameGoesOutAtOnce)
+{
+    report(0x10, 0x20, 0);
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(0x20, delivered[0].command);
+
+    // the slower receivers' copies are dropped
+    clockTime += 300;
+    report(0x10, 0x20, 0);
+    report(0x10, 0x20, 0x00040000);
+
+    BYTES_EQUAL(1, deliveredCount);
+    LONGS_EQUAL(2, combiner.copies);
+    LONGS_EQUAL(0, combiner.merged);
+}
+
+TEST(IR_Combiner, MergesBadBits)
+{
+    // each receiver lost a different address bit
+    report(0x10, 0x20, 0x00000001);
+    BYTES_EQUAL(0, deliveredCount);
+
+    clockTime += 200;
+    report(0x10, 0x20, 0x00000010);
+
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(0x10, delivered[0].address);
+    BYTES_EQUAL(0xEF, delivered[0].addressInv);
+    BYTES_EQUAL(0x20, delivered[0].command);
+    BYTES_EQUAL(0, delivered[0].addressError | delivered[0].commandError);
+    LONGS_EQUAL(1, combiner.merged);
+}
+
+TEST(IR_Combiner, CommandFromInverse)
+{
+    // a bad command bit is rebuilt from its inverse without waiting for another copy
+    report(0x10, 0x20, 0x00040000);
+
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(0x20, delivered[0].command);
+    BYTES_EQUAL(0, delivered[0].commandError);
+}
+
+TEST(IR_Combiner, WindowEndsWithErrors)
+{
+    report(0x10, 0x20, 0x00000100);
+    clockTime += WINDOW_US - 1;
+    IR_Combiner_Poll(&combiner);
+    BYTES_EQUAL(0, deliveredCount);
+
+    // no other receiver saw it, it goes out as the decoder reported it
+    clockTime++;
+    IR_Combiner_Poll(&combiner);
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(0x01, delivered[0].addressInvError);
+
+    // a copy after the window is a new frame
+    clockTime += 10;
+    report(0x10, 0x20, 0);
+    BYTES_EQUAL(2, deliveredCount);
+}
+
+TEST(IR_Combiner, PollHoldsOffCallback)
+{
+    combiner.lock = &fakeLock;
+    combiner.unlock = &fakeUnlock;
+    report(0x10, 0x20, 0x00000100);
+    clockTime += WINDOW_US;
+
+    // a new frame arrives while the main loop is handing out the held one
+    interruptArmed = 1;
+    IR_Combiner_Poll(&combiner);
+
+    BYTES_EQUAL(2, deliveredCount);
+    BYTES_EQUAL(0x20, delivered[0].command);
+    BYTES_EQUAL(0x01, delivered[0].addressInvError);
+    BYTES_EQUAL(0x21, delivered[1].command);
+    BYTES_EQUAL(0, delivered[1].addressInvError);
+    BYTES_EQUAL(0, masked);
+}
+
+TEST(IR_Combiner, DifferentFrameFlushes)
+{
+    report(0x10, 0x20, 0x00000100);
+
+    // a good bit disagrees, the held frame goes out before the new one
+    clockTime += 100;
+    report(0x10, 0x21, 0);
+
+    BYTES_EQUAL(2, deliveredCount);
+    BYTES_EQUAL(0x20, delivered[0].command);
+    BYTES_EQUAL(0x01, delivered[0].addressInvError);
+    BYTES_EQUAL(0x21, delivered[1].command);
+}
+
+TEST(IR_Combiner, RepeatsOnce)
+{
+    IR_Message_t repeat;
+
+    memset(&repeat, 0, sizeof(repeat));
+    repeat.repeat = 1;
+
+    IR_Combiner_Callback(&combiner, &repeat);
+    clockTime += 100;
+    IR_Combiner_Callback(&combiner, &repeat);
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(1, delivered[0].repeat);
+
+    // the next repeat is a code period later
+    clockTime += 108000;
+    IR_Combiner_Callback(&combiner, &repeat);
+    BYTES_EQUAL(2, deliveredCount);
+}
+
+TEST(IR_Combiner, RepeatSendsHeldFrame)
+{
+    IR_Message_t repeat;
+
+    report(0x10, 0x20, 0x00000100);
+
+    // the key is held down, the repeat comes well within the window
+    memset(&repeat, 0, sizeof(repeat));
+    repeat.repeat = 1;
+    clockTime += 100;
+    IR_Combiner_Callback(&combiner, &repeat);
+
+    BYTES_EQUAL(2, deliveredCount);
+    BYTES_EQUAL(0, delivered[0].repeat);
+    BYTES_EQUAL(0x20, delivered[0].command);
+    BYTES_EQUAL(0x01, delivered[0].addressInvError);
+    BYTES_EQUAL(1, delivered[1].repeat);
+    BYTES_EQUAL(0x10, delivered[1].address);
+    BYTES_EQUAL(0x20, delivered[1].command);
+    BYTES_EQUAL(0x01, delivered[1].addressInvError);
+}
+
+TEST(IR_Combiner, RepeatCarriesMergedFrame)
+{
+    IR_Message_t repeat;
+
+    report(0x10, 0x20, 0x00000001);
+    clockTime += 200;
+    report(0x10, 0x20, 0x00000010);
+    BYTES_EQUAL(1, deliveredCount);
+
+    // the receiver seeing the repeat got the frame's address wrong
+    memset(&repeat, 0, sizeof(repeat));
+    repeat.repeat = 1;
+    repeat.address = 0x11;
+    repeat.addressError = 0x01;
+    repeat.command = 0x20;
+    clockTime += 108000;
+    IR_Combiner_Callback(&combiner, &repeat);
+
+    BYTES_EQUAL(2, deliveredCount);
+    BYTES_EQUAL(1, delivered[1].repeat);
+    BYTES_EQUAL(0x10, delivered[1].address);
+    BYTES_EQUAL(0xEF, delivered[1].addressInv);
+    BYTES_EQUAL(0x20, delivered[1].command);
+    BYTES_EQUAL(0xDF, delivered[1].commandInv);
+    BYTES_EQUAL(0, delivered[1].addressError | delivered[1].addressInvError | delivered[1].commandError |
+                   delivered[1].commandInvError);
+}
+
+TEST(IR_Combiner, InverseMismatchGoesOutWithErrors)
+{
+    // every bit decoded but command bit 0 disagrees with its inverse, no other copy could settle it
+    reportFrame(0xDF20EF10 ^ 0x01000000, 0);
+
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(0x20, delivered[0].command);
+    BYTES_EQUAL(0xDE, delivered[0].commandInv);
+    BYTES_EQUAL(0x01, delivered[0].commandError);
+    BYTES_EQUAL(0x01, delivered[0].commandInvError);
+    BYTES_EQUAL(0, delivered[0].addressError | delivered[0].addressInvError);
+}
+
+TEST(IR_Combiner, InverseMismatchAfterMerging)
+{
+    // the second copy fills the last unknown bit, the frame goes out without waiting for the window
+    reportFrame(0xDF20EF10 ^ 0x00020000 ^ 0x00000001, 0x00000001);
+    BYTES_EQUAL(0, deliveredCount);
+
+    clockTime += 100;
+    reportFrame(0xDF20EF10 ^ 0x00020000, 0x00020000);
+
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(0x10, delivered[0].address);
+    BYTES_EQUAL(0x02, delivered[0].commandError);
+    BYTES_EQUAL(0x02, delivered[0].commandInvError);
+    BYTES_EQUAL(0, delivered[0].addressError | delivered[0].addressInvError);
+    LONGS_EQUAL(0, combiner.merged);
+}
+
+TEST(IR_Combiner, Decoders)
+{
+    static uint8_t arenas[2][IR_DECODER_SIZE(0)];
+    IR_Decoder_t *decoders[2];
+    uint64_t times[IR_ENCODER_FRAME_EDGES];
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        // timestamps in ticks without a capture ring
+        decoders[i] = IR_Decoder_Create(arenas[i], sizeof(arenas[i]), 0, CLOCK_SPEED_MHZ, 0, NULL);
+        decoders[i]->contextCallback = &IR_Combiner_Callback;
+        decoders[i]->callbackContext = &combiner;
+    }
+
+    // each receiver mangles a different address bit
+    IR_Decoder_DecodeTimestamps(decoders[0], times, frameTimestamps(1000, 0x5A, 3, times));
+    BYTES_EQUAL(0, deliveredCount);
+    clockTime += 50;
+    IR_Decoder_DecodeTimestamps(decoders[1], times, frameTimestamps(1000, 0x5A, 12, times));
+
+    BYTES_EQUAL(1, deliveredCount);
+    BYTES_EQUAL(0x00, delivered[0].address);
+    BYTES_EQUAL(0xFF, delivered[0].addressInv);
+    BYTES_EQUAL(0x5A, delivered[0].command);
+    BYTES_EQUAL(0, delivered[0].addressError | delivered[0].addressInvError | delivered[0].commandError |
+                   delivered[0].commandInvError);
+}
+
+TEST(IR_Combiner, Yield)
+{
+    uint32_t seed = 0xC0FFEE;
+    uint16_t single = 0;
+    uint16_t clean = 0;
+    const uint16_t sent = 10000;
+
+    // three receivers, each bit is lost by a receiver one time in 64
+    for (uint16_t frame = 0; frame < sent; frame++)
+    {
+        for (uint8_t receiver = 0; receiver < 3; receiver++)
+        {
+            uint32_t errors = 0;
+
+            for (uint8_t bit = 0; bit < 32; bit++)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                errors |= (uint32_t)((seed & 63) == 0) << bit;
+            }
+
+            single += !receiver && !errors;
+            report(0x10, frame, errors);
+            clockTime += 100;
+        }
+
+        clockTime += WINDOW_US;
+        IR_Combiner_Poll(&combiner);
+        clean += deliveredCount && !(delivered[0].addressError | delivered[0].addressInvError |
+                                     delivered[0].commandError | delivered[0].commandInvError);
+        deliveredCount = 0;
+    }
+
+    CHECK(clean > single);
+    CHECK(clean > sent * 99 / 100);
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    raiseInterrupt();
+    if (deliveredCount < MAX_DELIVERED)
+    {
+        delivered[deliveredCount] = *pMessage;
+    }
+    deliveredCount++;
+}
+
+static uint32_t fakeClock(void)
+{
+    return clockTime;
+}
+
+static void raiseInterrupt(void)
+{
+    if (!interruptArmed)
+    {
+        return;
+    }
+
+    interruptArmed = 0;
+    if (masked)
+    {
+        interruptHeld = 1;
+        return;
+    }
+    report(0x10, 0x21, 0);
+}
+
+static uint32_t fakeLock(void)
+{
+    uint32_t state = masked;
+
+    masked = 1;
+    return state;
+}
+
+static void fakeUnlock(uint32_t state)
+{
+    masked = state;
+    if (!masked && interruptHeld)
+    {
+        interruptHeld = 0;
+        report(0x10, 0x21, 0);
+    }
+}
+
+static void report(uint8_t address, uint8_t command, uint32_t errors)
+{
+    // the bits flagged as errors came out wrong
+    reportFrame((address | (uint32_t)(uint8_t)~address << 8 | (uint32_t)command << 16 |
+                 (uint32_t)(uint8_t)~command << 24) ^ errors, errors);
+}
+
+static void reportFrame(uint32_t frame, uint32_t errors)
+{
+    IR_Message_t message;
+
+    memset(&message, 0, sizeof(message));
+    message.address = frame;
+    message.addressInv = frame >> 8;
+    message.command = frame >> 16;
+    message.commandInv = frame >> 24;
+    message.addressError = errors;
+    message.addressInvError = errors >> 8;
+    message.commandError = errors >> 16;
+    message.commandInvError = errors >> 24;
+    IR_Combiner_Callback(&combiner, &message);
+}
+
+// an encoded frame with the space of badBit between a zero and a one
+static uint16_t frameTimestamps(uint64_t start, uint8_t command, uint8_t badBit, uint64_t *times)
+{
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, start, 0x00, command, times);
+    uint8_t space = 4 + 2 * badBit;
+    int64_t stretch = 1100 * CLOCK_SPEED_MHZ - (int64_t)(times[space] - times[space - 1]);
+
+    for (uint16_t i = space; i < count; i++)
+    {
+        times[i] += stretch;
+    }
+
+    return count;
+}
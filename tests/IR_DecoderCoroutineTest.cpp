@@ -0,0 +1,116 @@
+#include "IR_Decoder.hpp"
+
+extern "C"
+{
+#include "IR_Encoder.h"
+#include "IR_Generator.h"
+}
+
+#include <coroutine>
+#include <exception>
+
+#include "CppUTest/TestHarness.h"
+
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+#define FRAME_EDGES     IR_ENCODER_FRAME_EDGES
+
+// minimal eager coroutine, destroyed with its owner
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Task(const Task &) = delete;
+    ~Task() { handle.destroy(); }
+
+    bool done() const { return handle.done(); }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+static uint8_t commands[8];
+static uint8_t received;
+
+static Task receive(IR::Decoder &decoder, uint8_t count);
+
+TEST_GROUP(IR_DecoderCoroutine)
+{
+    void setup()
+    {
+        received = 0;
+    }
+};
+
+TEST(IR_DecoderCoroutine, AwaitsFramesInOrder)
+{
+    IR::Decoder decoder(0, CLOCK_SPEED_MHZ, PERIOD);
+    uint64_t times[FRAME_EDGES];
+    Task task = receive(decoder, 2);
+
+    BYTES_EQUAL(0, received);
+
+    // split mid frame, nothing is resumed until the frame completes
+    IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x21, times);
+    decoder.decode_timestamps(times, 30);
+    BYTES_EQUAL(0, received);
+    decoder.decode_timestamps(&times[30], FRAME_EDGES - 30);
+    BYTES_EQUAL(1, received);
+    BYTES_EQUAL(0x21, commands[0]);
+
+    IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000 + 108000 * CLOCK_SPEED_MHZ, 0x00, 0x22, times);
+    decoder.decode_timestamps(times, FRAME_EDGES);
+    BYTES_EQUAL(2, received);
+    BYTES_EQUAL(0x22, commands[1]);
+    CHECK(task.done());
+}
+
+TEST(IR_DecoderCoroutine, QueuedFramesAreReady)
+{
+    IR::Decoder decoder(0, CLOCK_SPEED_MHZ, PERIOD);
+    uint64_t times[FRAME_EDGES];
+
+    // frames decoded before anyone awaits are kept
+    IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x41, times);
+    decoder.decode_timestamps(times, FRAME_EDGES);
+    IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000 + 108000 * CLOCK_SPEED_MHZ, 0x00, 0x42, times);
+    decoder.decode_timestamps(times, FRAME_EDGES);
+    LONGS_EQUAL(2, decoder.pending());
+
+    Task task = receive(decoder, 2);
+
+    CHECK(task.done());
+    BYTES_EQUAL(0x41, commands[0]);
+    BYTES_EQUAL(0x42, commands[1]);
+    LONGS_EQUAL(0, decoder.pending());
+}
+
+TEST(IR_DecoderCoroutine, DecodeWithoutRing)
+{
+    IR::Decoder decoder(0, CLOCK_SPEED_MHZ, PERIOD);
+    uint64_t times[FRAME_EDGES];
+
+    // no capture ring to read, the timestamp calls still decode
+    decoder.decode();
+    IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x51, times);
+    decoder.decode_timestamps(times, FRAME_EDGES);
+    decoder.decode();
+    LONGS_EQUAL(1, decoder.pending());
+}
+
+static Task receive(IR::Decoder &decoder, uint8_t count)
+{
+    while (received < count)
+    {
+        IR_Message_t message = co_await decoder.next_frame();
+
+        commands[received++] = message.command;
+    }
+}
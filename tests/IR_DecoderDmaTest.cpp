@@ -0,0 +1,999 @@
+extern "C"
+{
+#include "IR_Decoder.h"
+#include "IR_Encoder.h"
+#include "IR_Generator.h"
+
+#include <string.h>
+}
+
+#include "CppUTest/TestHarness.h"
+
+#define BUFFER_SIZE     136
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+
+#define FRAME_EDGES     68
+#define REPEAT_EDGES    4
+
+#define POLL_MS         100
+#define IDLE_MS         300
+#define TRACE_EDGES     1024
+
+// fake circular DMA channel feeding the capture ring, the duration ring and, when used, the rising ring
+static uint32_t data[BUFFER_SIZE];
+static uint16_t durations[BUFFER_SIZE];
+static uint32_t risingData[BUFFER_SIZE];
+static IR_GeneratorDma_t dma;
+static uint32_t frameGap;
+
+#ifdef IR_DECODER_CARRIER
+// raw receiver without a demodulator, every mark is a burst of 38kHz cycles on the one ring
+static uint8_t carrierMark;
+static uint32_t carrierLeft;
+#endif
+
+// frames are encoded in us, only the widths between their edges are written
+static IR_Encoder_t encoder;
+
+static IR_Decoder_t decoder;
+static IR_Message_t message;
+static uint8_t frames;
+static uint8_t decodedAddress;
+static uint8_t decodedCommand;
+static uint8_t repeatCommand;
+static uint32_t callbackLog; // hash of every callback in order
+
+// edge times of a simulated usage trace in us since the start
+static uint32_t trace[TRACE_EDGES];
+static uint16_t traceLength;
+static uint32_t traceTime;
+static void (*writeEdge)(uint32_t us);
+
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint32_t fakeDmaRemaining(void);
+static void fakeDmaReset(void);
+static uint64_t fakeCaptureNow(void);
+static void fakeDmaWrite(uint32_t us);
+#ifdef IR_DECODER_DUAL_RING
+static uint32_t fakeRisingRemaining(void);
+static void fakeDualWrite(uint32_t us);
+static void fakeDualDrop(uint32_t us);
+static void useDualRing(void);
+#endif
+#ifdef IR_DECODER_CARRIER
+static void fakeCarrierWrite(uint32_t us);
+#endif
+static void fakeDmaFrame(uint8_t address, uint8_t command);
+static void fakeDmaRepeat(void);
+static void fakeEncoded(uint32_t gap, const uint32_t *edges, uint8_t count);
+static void traceWrite(uint32_t us);
+
+TEST_GROUP(IR_DecoderDma)
+{
+    void setup()
+    {
+        writeEdge = &fakeDmaWrite;
+        fakeDmaReset();
+    }
+
+    void teardown()
+    {
+        memset(data, 0, sizeof(data));
+    }
+};
+
+TEST(IR_DecoderDma, NoNewEdges)
+{
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(0, decoder.currentIndex);
+    BYTES_EQUAL(0, decoder.writeIndex);
+    CHECK(decoder.state == LeadIn);
+}
+
+TEST(IR_DecoderDma, PartialFrame)
+{
+    fakeDmaFrame(0x12, 0x34);
+    dma.index = 20;
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(20, decoder.writeIndex);
+    BYTES_EQUAL(18, decoder.currentIndex);
+    BYTES_EQUAL(8, decoder.pulseNumber);
+    CHECK(decoder.state == AddressInv);
+    BYTES_EQUAL(0, frames);
+}
+
+TEST(IR_DecoderDma, FullFrameLeavesBufferUntouched)
+{
+    uint32_t copy[BUFFER_SIZE];
+
+    fakeDmaFrame(0x00, 0x16);
+    memcpy(copy, data, sizeof(data));
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x16, decodedCommand);
+    BYTES_EQUAL(0xE9, message.commandInv);
+    BYTES_EQUAL(0, message.commandError);
+    BYTES_EQUAL(FRAME_EDGES, decoder.currentIndex);
+    CHECK(decoder.state == LeadIn);
+    MEMCMP_EQUAL(copy, data, sizeof(data));
+}
+
+TEST(IR_DecoderDma, ZeroTimestamp)
+{
+    // a capture of 0 is an ordinary value once the write position is known
+    dma.time = PERIOD - (40000 + 9000) * CLOCK_SPEED_MHZ;
+    fakeDmaFrame(0x07, 0x45);
+
+    LONGLONGS_EQUAL(0, data[1]);
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x07, decodedAddress);
+    BYTES_EQUAL(0x45, decodedCommand);
+}
+
+TEST(IR_DecoderDma, MissingTrailingEdge)
+{
+    fakeDmaFrame(0x00, 0x16);
+    dma.index--;
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(FRAME_EDGES, decoder.currentIndex);
+    BYTES_EQUAL(1, decoder.clearLast);
+
+    IR_Decoder_Decode(&decoder);
+    BYTES_EQUAL(1, decoder.clearLast);
+
+    dma.index++;
+    fakeDmaRepeat();
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(0, decoder.clearLast);
+    BYTES_EQUAL(1, repeatCommand);
+    BYTES_EQUAL(FRAME_EDGES + REPEAT_EDGES, decoder.currentIndex);
+}
+
+TEST(IR_DecoderDma, WrapAround)
+{
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        fakeDmaFrame(i, 0x80 | i);
+        IR_Decoder_Decode(&decoder);
+
+        BYTES_EQUAL(i + 1, frames);
+        BYTES_EQUAL(i, decodedAddress);
+        BYTES_EQUAL(0x80 | i, decodedCommand);
+        BYTES_EQUAL(0, message.addressError | message.commandError);
+    }
+
+    BYTES_EQUAL(5 * FRAME_EDGES % BUFFER_SIZE, decoder.currentIndex);
+    BYTES_EQUAL(2, dma.fullTransfers);
+}
+
+TEST(IR_DecoderDma, HalfAndFullTransferEvents)
+{
+    uint8_t half = dma.halfTransfers;
+    uint8_t full = dma.fullTransfers;
+
+    // decode only from the DMA half/full transfer interrupts
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        fakeDmaFrame(0x20 + i, 0x40 + i);
+        fakeDmaRepeat();
+
+        if (dma.halfTransfers != half || dma.fullTransfers != full)
+        {
+            half = dma.halfTransfers;
+            full = dma.fullTransfers;
+            IR_Decoder_Decode(&decoder);
+        }
+    }
+
+    BYTES_EQUAL(4 * (FRAME_EDGES + REPEAT_EDGES) % BUFFER_SIZE, decoder.writeIndex);
+    CHECK(frames >= 3);
+    BYTES_EQUAL(0x40 + frames - 1, decodedCommand);
+}
+
+TEST(IR_DecoderDma, Lapped)
+{
+    // three frames is more than the ring holds, the first two are overwritten
+    fakeDmaFrame(0x01, 0x11);
+    fakeDmaFrame(0x02, 0x22);
+    fakeDmaFrame(0x03, 0x33);
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, decoder.overruns);
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x03, decodedAddress);
+    BYTES_EQUAL(0x33, decodedCommand);
+    BYTES_EQUAL(0, message.addressError | message.addressInvError | message.commandError | message.commandInvError);
+
+    fakeDmaFrame(0x04, 0x44);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, decoder.overruns);
+    BYTES_EQUAL(2, frames);
+    BYTES_EQUAL(0x44, decodedCommand);
+}
+
+TEST(IR_DecoderDma, LappedOddEdges)
+{
+    // a stray edge makes the discarded count odd, the kept half starts on the last lead-in
+    fakeDmaWrite(20000);
+    fakeDmaFrame(0x01, 0x11);
+    fakeDmaFrame(0x02, 0x22);
+    fakeDmaFrame(0x03, 0x33);
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, decoder.overruns);
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x33, decodedCommand);
+}
+
+TEST(IR_DecoderDma, LappedMidFrame)
+{
+    // the decoder stops half way through a frame and the DMA laps it, the kept
+    // span starts inside a frame and ends with a repeat of it
+    fakeDmaFrame(0x01, 0x11);
+    dma.index = 34;
+    IR_Decoder_Decode(&decoder);
+    CHECK(decoder.state != LeadIn);
+
+    fakeDmaFrame(0x01, 0x11);
+    fakeDmaFrame(0x02, 0x22);
+    fakeDmaFrame(0x03, 0x33);
+    fakeDmaRepeat();
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, decoder.overruns);
+    BYTES_EQUAL(0, decoder.pulseNumber);
+    CHECK(decoder.state == Resync);
+    BYTES_EQUAL(0, frames);
+    BYTES_EQUAL(0, repeatCommand);
+
+    fakeDmaFrame(0x05, 0x55);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x05, decodedAddress);
+    BYTES_EQUAL(0x55, decodedCommand);
+    BYTES_EQUAL(0, message.addressError | message.addressInvError | message.commandError | message.commandInvError);
+}
+
+TEST(IR_DecoderDma, WrapInterruptPending)
+{
+    fakeDmaFrame(0x01, 0x11);
+    IR_Decoder_Decode(&decoder);
+
+    // NDTR has reloaded but the transfer complete interrupt has not run
+    dma.wrapIrq = 0;
+    fakeDmaFrame(0x02, 0x22);
+    fakeDmaRepeat();
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(0, decoder.overruns);
+    BYTES_EQUAL(2, frames);
+    BYTES_EQUAL(0x22, decodedCommand);
+    BYTES_EQUAL(1, repeatCommand);
+
+    IR_Decoder_CaptureWrapped(&decoder);
+    fakeDmaFrame(0x03, 0x33);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(0, decoder.overruns);
+    BYTES_EQUAL(3, frames);
+    BYTES_EQUAL(0x33, decodedCommand);
+}
+
+TEST(IR_DecoderDma, IdleAfterQuietDecodes)
+{
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+
+    CHECK_FALSE(IR_Decoder_IsIdle(&decoder, POLL_MS, IDLE_MS));
+
+    IR_Decoder_Decode(&decoder);
+    IR_Decoder_Decode(&decoder);
+    CHECK_FALSE(IR_Decoder_IsIdle(&decoder, POLL_MS, IDLE_MS));
+
+    IR_Decoder_Decode(&decoder);
+    CHECK_TRUE(IR_Decoder_IsIdle(&decoder, POLL_MS, IDLE_MS));
+
+    // a single new edge restarts the idle time
+    writeEdge(40000);
+    IR_Decoder_Decode(&decoder);
+    CHECK_FALSE(IR_Decoder_IsIdle(&decoder, POLL_MS, IDLE_MS));
+}
+
+TEST(IR_DecoderDma, NotIdleMidFrame)
+{
+    fakeDmaFrame(0x00, 0x16);
+    dma.index = 40;
+
+    // 2ms without an edge is past idleMs but within the edge timeout, the frame may still finish
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        IR_Decoder_Decode(&decoder);
+    }
+
+    CHECK_FALSE(IR_Decoder_IsIdle(&decoder, 1, 1));
+    CHECK(decoder.state == Command);
+}
+
+TEST(IR_DecoderDma, IdleAfterTruncatedFrame)
+{
+    // interference cut a frame off after 10 bits, then nothing
+    fakeDmaFrame(0x00, 0x16);
+    dma.index = 23;
+
+    for (uint8_t i = 0; i < 100; i++)
+    {
+        IR_Decoder_Decode(&decoder);
+    }
+    CHECK(decoder.state == AddressInv);
+
+    CHECK_TRUE(IR_Decoder_IsIdle(&decoder, POLL_MS, 1000));
+    CHECK(decoder.state == Resync);
+    LONGS_EQUAL(1, decoder.timeouts);
+
+    // the next keypress decodes
+    fakeDmaFrame(0x00, 0x17);
+    IR_Decoder_Resume(&decoder);
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x17, decodedCommand);
+}
+
+TEST(IR_DecoderDma, ResumeDecodesBatch)
+{
+    // edges captured while asleep are decoded by a single call
+    fakeDmaFrame(0x00, 0x16);
+    fakeDmaRepeat();
+    fakeDmaRepeat();
+    IR_Decoder_Resume(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(2, repeatCommand);
+    BYTES_EQUAL(0, decoder.quietDecodes);
+}
+
+TEST(IR_DecoderDma, IdleSimulation)
+{
+    IR_GeneratorTrace_t keypresses = {trace, 0, 30000, POLL_MS, IDLE_MS, NULL, 0};
+    uint16_t polledFrames;
+    uint16_t polled;
+    uint16_t idle;
+
+    // a few keypresses over 30s, some held down for repeats
+    IR_Generator_Keypress(&keypresses, 1000, 0x10, 2);
+    IR_Generator_Keypress(&keypresses, 5000, 0x11, 0);
+    IR_Generator_Keypress(&keypresses, 5400, 0x12, 1);
+    IR_Generator_Keypress(&keypresses, 12000, 0x13, 8);
+    IR_Generator_Keypress(&keypresses, 25000, 0x14, 0);
+
+    polled = IR_Generator_Simulate(&keypresses, &dma, 0);
+    polledFrames = frames;
+    fakeDmaReset();
+    idle = IR_Generator_Simulate(&keypresses, &dma, 1);
+
+    LONGS_EQUAL(5, polledFrames);
+    LONGS_EQUAL(polledFrames, frames);
+    CHECK(idle * 5 < polled);
+}
+
+#ifdef IR_DECODER_DURATIONS
+TEST(IR_DecoderDma, DurationRing)
+{
+    decoder.durationBuffer = durations;
+    IR_Decoder_Init(&decoder);
+
+    fakeDmaFrame(0x12, 0x34);
+    dma.index -= 48;
+    IR_Decoder_Decode(&decoder);
+    CHECK(decoder.state == AddressInv);
+
+    dma.index += 48;
+    fakeDmaRepeat();
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x12, decodedAddress);
+    BYTES_EQUAL(0x34, decodedCommand);
+    BYTES_EQUAL(1, repeatCommand);
+    BYTES_EQUAL(FRAME_EDGES + REPEAT_EDGES, decoder.currentIndex);
+}
+
+TEST(IR_DecoderDma, DurationRingWrapAndLap)
+{
+    decoder.durationBuffer = durations;
+    IR_Decoder_Init(&decoder);
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        fakeDmaFrame(0x00, 0x20 + i);
+        IR_Decoder_Decode(&decoder);
+    }
+    BYTES_EQUAL(5, frames);
+    BYTES_EQUAL(0x24, decodedCommand);
+
+    // three frames without a decode lap the ring, the newest one still decodes
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        fakeDmaFrame(0x00, 0x30 + i);
+    }
+    fakeDmaFrame(0x00, 0x40);
+    IR_Decoder_Decode(&decoder);
+
+    LONGS_EQUAL(1, decoder.overruns);
+    BYTES_EQUAL(0x40, decodedCommand);
+}
+#endif
+
+TEST(IR_DecoderDma, DuplicateSuppressedTimestampRing)
+{
+    decoder.duplicateWindow = 20000;
+    decoder.captureNow = &fakeCaptureNow;
+
+    // the capture clock tells 5ms behind from a period and 5ms behind
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+    frameGap = 5000;
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    LONGS_EQUAL(1, decoder.duplicates);
+    LONGS_EQUAL(550 + 5000, decoder.leadInGap);
+
+    frameGap = PERIOD / CLOCK_SPEED_MHZ + 5000;
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(2, frames);
+    LONGS_EQUAL(1, decoder.duplicates);
+    LONGS_EQUAL(550 + PERIOD / CLOCK_SPEED_MHZ + 5000, decoder.leadInGap);
+
+#ifdef IR_DECODER_DUAL_RING
+    // the same on the dual ring
+    useDualRing();
+    frameGap = 5000;
+    fakeDmaFrame(0x00, 0x17);
+    IR_Decoder_Decode(&decoder);
+    fakeDmaFrame(0x00, 0x17);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(3, frames);
+    LONGS_EQUAL(1, decoder.duplicates);
+    LONGS_EQUAL(550 + 5000, decoder.leadInGap);
+#endif
+}
+
+TEST(IR_DecoderDma, EdgesOnCaptureClock)
+{
+    decoder.captureNow = &fakeCaptureNow;
+
+    // the lead-in comes two and a half periods in, the ring only holds the counter
+    frameGap = 250000;
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    LONGLONGS_EQUAL(1000 + 250000ULL * CLOCK_SPEED_MHZ, message.firstEdge);
+    // the end of the last space, the stop mark follows
+    LONGLONGS_EQUAL(dma.clock - 550 * CLOCK_SPEED_MHZ, message.lastEdge);
+}
+
+TEST(IR_DecoderDma, DuplicateGapUnknownOnTimestampRing)
+{
+    decoder.duplicateWindow = 20000;
+
+    // without captureNow 5ms behind and a period and 5ms behind read the same once the ring wraps,
+    // neither is dropped
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+    frameGap = 5000;
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+    frameGap = PERIOD / CLOCK_SPEED_MHZ + 5000;
+    fakeDmaFrame(0x00, 0x16);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(3, frames);
+    LONGS_EQUAL(0, decoder.duplicates);
+    LONGLONGS_EQUAL(UINT32_MAX, decoder.leadInGap);
+}
+
+#ifdef IR_DECODER_DURATIONS
+TEST(IR_DecoderDma, DuplicateSuppressedDurationRing)
+{
+    decoder.duplicateWindow = 20000;
+    decoder.durationBuffer = durations;
+    IR_Decoder_Init(&decoder);
+
+    // the gap is measured in the duration ring
+    fakeDmaFrame(0x05, 0x60);
+    IR_Decoder_Decode(&decoder);
+    frameGap = 19000;
+    fakeDmaFrame(0x05, 0x60);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    LONGS_EQUAL(1, decoder.duplicates);
+
+    frameGap = 20000;
+    fakeDmaFrame(0x05, 0x60);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(2, frames);
+
+    // a different key within the window is kept
+    frameGap = 5000;
+    fakeDmaFrame(0x05, 0x61);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(3, frames);
+
+    // a width clamped at 65535us leaves the gap unknown, whatever the window
+    decoder.duplicateWindow = 100000;
+    frameGap = 70000;
+    fakeDmaFrame(0x05, 0x61);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(4, frames);
+    LONGS_EQUAL(1, decoder.duplicates);
+}
+#endif
+
+TEST(IR_DecoderDma, EdgeTimeout)
+{
+    // the first 30 edges of a frame, then the next keypress
+    writeEdge = &traceWrite;
+    traceLength = 0;
+    traceTime = 0;
+    fakeDmaFrame(0x00, 0x16);
+    writeEdge = &fakeDmaWrite;
+    for (uint16_t edge = 0; edge < 30; edge++)
+    {
+        fakeDmaWrite(trace[edge] - (edge ? trace[edge - 1] : 0));
+    }
+    IR_Decoder_Decode(&decoder);
+    CHECK(decoder.state == AddressInv);
+
+    fakeDmaFrame(0x00, 0x17);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x17, decodedCommand);
+    BYTES_EQUAL(0, message.commandError);
+    LONGS_EQUAL(1, decoder.timeouts);
+}
+
+TEST(IR_DecoderDma, BoundedDecodeMatchesUnbounded)
+{
+#ifdef IR_DECODER_DURATIONS
+    const uint8_t rings = 2;
+#else
+    const uint8_t rings = 1;
+#endif
+    uint32_t expectedLog = 0;
+    uint16_t expectedOverruns = 0;
+
+    // budget 0 is the IR_Decoder_Decode reference run for each ring
+    for (uint16_t run = 0; run < rings * 40; run++)
+    {
+        uint16_t budget = run % 40;
+
+        fakeDmaReset();
+#ifdef IR_DECODER_DURATIONS
+        decoder.durationBuffer = run >= 40 ? durations : NULL;
+        IR_Decoder_Init(&decoder);
+#endif
+
+        for (uint8_t i = 0; i < 12; i++)
+        {
+            // a frame and a repeat, every fourth time with two more frames that lap the ring
+            writeEdge = &traceWrite;
+            traceLength = 0;
+            traceTime = 0;
+            fakeDmaFrame(i, 0x40 + i);
+            fakeDmaRepeat();
+            if (i % 4 == 3)
+            {
+                fakeDmaFrame(0x7F, 0x7F);
+                fakeDmaFrame(0x7E, 0x7E);
+            }
+            writeEdge = &fakeDmaWrite;
+
+            // decoded in two parts, the first ending mid frame
+            for (uint16_t edge = 0; edge < traceLength; edge++)
+            {
+                fakeDmaWrite(trace[edge] - (edge ? trace[edge - 1] : 0));
+                if (edge != 47 && edge != traceLength - 1)
+                {
+                    continue;
+                }
+
+                if (!budget)
+                {
+                    IR_Decoder_Decode(&decoder);
+                    continue;
+                }
+
+                for (;;)
+                {
+                    uint8_t start = decoder.currentIndex;
+                    uint16_t overruns = decoder.overruns;
+                    uint8_t pending = IR_Decoder_DecodeBounded(&decoder, budget);
+
+                    // two edges a pulse, four when it ends a frame or repeat, unless lapped edges were dropped
+                    CHECK(decoder.overruns != overruns ||
+                          (decoder.currentIndex + BUFFER_SIZE - start) % BUFFER_SIZE <= 4 * budget);
+                    if (!pending)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!budget)
+        {
+            expectedLog = callbackLog;
+            expectedOverruns = decoder.overruns;
+            LONGS_EQUAL(12, frames);
+            LONGS_EQUAL(3, expectedOverruns);
+        }
+        else
+        {
+            LONGS_EQUAL(expectedLog, callbackLog);
+            LONGS_EQUAL(expectedOverruns, decoder.overruns);
+        }
+    }
+}
+
+#ifdef IR_DECODER_DURATIONS
+TEST(IR_DecoderDma, DurationRingFootprint)
+{
+    const uint16_t count = 2000;
+    uint16_t timestampFrames = 0;
+
+    // the same frames through both rings, a decode per frame
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        fakeDmaReset();
+        decoder.durationBuffer = pass ? durations : NULL;
+        IR_Decoder_Init(&decoder);
+
+        for (uint16_t i = 0; i < count; i++)
+        {
+            fakeDmaFrame(0x00, (uint8_t)i);
+            IR_Decoder_Decode(&decoder);
+        }
+
+        if (!pass)
+        {
+            timestampFrames = frames;
+        }
+    }
+
+    LONGS_EQUAL(count % 256, timestampFrames);
+    LONGS_EQUAL(timestampFrames, frames);
+    LONGS_EQUAL(2 * sizeof(durations), sizeof(data));
+}
+#endif
+
+#ifdef IR_DECODER_DUAL_RING
+TEST(IR_DecoderDma, DualRing)
+{
+    useDualRing();
+    dma.time = PERIOD - 30000 * CLOCK_SPEED_MHZ;
+
+    // the timer wraps in the first frame's lead-in gap
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        fakeDmaFrame(0x11, 0x60 + i);
+        IR_Decoder_Decode(&decoder);
+    }
+    fakeDmaRepeat();
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(6, frames);
+    BYTES_EQUAL(0x11, decodedAddress);
+    BYTES_EQUAL(0x65, decodedCommand);
+    BYTES_EQUAL(0, message.commandError);
+    BYTES_EQUAL(1, repeatCommand);
+    LONGS_EQUAL(0, decoder.overruns);
+    CHECK(decoder.risingIndex != 0);
+}
+
+TEST(IR_DecoderDma, DualRingDecodedEdgeByEdge)
+{
+    writeEdge = &traceWrite;
+    traceLength = 0;
+    traceTime = 0;
+    fakeDmaFrame(0x00, 0x51);
+    fakeDmaFrame(0x00, 0x52);
+
+    // one ring is always a capture ahead of the other
+    useDualRing();
+    for (uint16_t edge = 0; edge < traceLength; edge++)
+    {
+        fakeDualWrite(trace[edge] - (edge ? trace[edge - 1] : 0));
+        IR_Decoder_Decode(&decoder);
+    }
+
+    BYTES_EQUAL(2, frames);
+    BYTES_EQUAL(0x52, decodedCommand);
+    BYTES_EQUAL(0, message.commandError);
+}
+
+TEST(IR_DecoderDma, DualRingLostEdge)
+{
+    writeEdge = &traceWrite;
+    traceLength = 0;
+    traceTime = 0;
+    fakeDmaFrame(0x00, 0x71);
+    fakeDmaFrame(0x00, 0x72);
+
+    // a rising edge in the first frame is never captured
+    useDualRing();
+    for (uint16_t edge = 0; edge < traceLength; edge++)
+    {
+        uint32_t us = trace[edge] - (edge ? trace[edge - 1] : 0);
+
+        if (edge == 31)
+        {
+            fakeDualDrop(us);
+        }
+        else
+        {
+            fakeDualWrite(us);
+        }
+    }
+    IR_Decoder_Decode(&decoder);
+
+    // the damaged frame runs one bit short into the next gap, the next frame still decodes
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x72, decodedCommand);
+    BYTES_EQUAL(0, message.commandError);
+    LONGS_EQUAL(1, decoder.timeouts);
+}
+
+TEST(IR_DecoderDma, DualRingLapped)
+{
+    useDualRing();
+
+    // each ring holds four frames of 34 captures
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        fakeDmaFrame(0x00, 0x30 + i);
+    }
+    IR_Decoder_Decode(&decoder);
+    LONGS_EQUAL(1, decoder.overruns);
+    BYTES_EQUAL(0, frames);
+
+    fakeDmaFrame(0x00, 0x40);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, frames);
+    BYTES_EQUAL(0x40, decodedCommand);
+    LONGS_EQUAL(1, decoder.overruns);
+}
+
+TEST(IR_DecoderDma, DualRingMatchesSingle)
+{
+    const uint16_t count = 2000;
+    uint16_t singleFrames = 0;
+
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        fakeDmaReset();
+        if (pass)
+        {
+            useDualRing();
+        }
+
+        for (uint16_t i = 0; i < count; i++)
+        {
+            fakeDmaFrame(0x00, (uint8_t)i);
+            IR_Decoder_Decode(&decoder);
+        }
+
+        if (!pass)
+        {
+            singleFrames = frames;
+        }
+    }
+
+    LONGS_EQUAL(count % 256, singleFrames);
+    LONGS_EQUAL(singleFrames, frames);
+}
+#endif
+
+#ifdef IR_DECODER_CARRIER
+TEST(IR_DecoderDma, CarrierRing)
+{
+    writeEdge = &fakeCarrierWrite;
+    decoder.carrierGap = 100;
+    dma.time = PERIOD - 30000 * CLOCK_SPEED_MHZ;
+
+    // a frame is several laps of the ring, the timer wraps in the first lead-in gap
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        fakeDmaFrame(0x12, 0x70 + i);
+    }
+    fakeDmaRepeat();
+    writeEdge(40000);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(3, frames);
+    BYTES_EQUAL(0x12, decodedAddress);
+    BYTES_EQUAL(0x72, decodedCommand);
+    BYTES_EQUAL(0, message.addressError | message.addressInvError | message.commandError | message.commandInvError);
+    BYTES_EQUAL(1, repeatCommand);
+    LONGS_EQUAL(0, decoder.overruns);
+}
+#endif
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    if (pMessage)
+    {
+        callbackLog = callbackLog * 31 + (pMessage->address << 16 | pMessage->repeat << 8 | pMessage->command);
+
+        if (pMessage->repeat)
+        {
+            repeatCommand = pMessage->repeat;
+        }
+        else
+        {
+            frames++;
+            decodedAddress = pMessage->address;
+            decodedCommand = pMessage->command;
+        }
+    }
+}
+
+static uint32_t fakeDmaRemaining(void)
+{
+    return IR_Generator_DmaRemaining(&dma);
+}
+
+static void traceWrite(uint32_t us)
+{
+    traceTime += us;
+    trace[traceLength++] = traceTime;
+}
+
+static void fakeDmaReset(void)
+{
+    frames = 0;
+    decodedAddress = 0;
+    decodedCommand = 0;
+    repeatCommand = 0;
+    callbackLog = 0;
+    frameGap = 40000;
+#ifdef IR_DECODER_CARRIER
+    carrierMark = 0;
+    carrierLeft = 0;
+#endif
+    encoder.period = PERIOD;
+    encoder.clockSpeed = 1;
+    IR_Encoder_Init(&encoder, 0);
+    dma.decoder = &decoder;
+    dma.data = data;
+    dma.durations = durations;
+    dma.risingData = risingData;
+    dma.size = BUFFER_SIZE;
+    dma.period = PERIOD;
+    dma.clockSpeed = CLOCK_SPEED_MHZ;
+    IR_Generator_DmaInit(&dma, 1000);
+    IR_Decoder_ConfigDefaults(&decoder);
+    decoder.buffer = data;
+    decoder.bufferSize = BUFFER_SIZE;
+    decoder.clockSpeed = CLOCK_SPEED_MHZ;
+    decoder.period = PERIOD;
+    decoder.message = &message;
+    decoder.decodeCallback = &decodeFinished_callback;
+    decoder.captureRemaining = &fakeDmaRemaining;
+    IR_Decoder_Init(&decoder);
+}
+
+static uint64_t fakeCaptureNow(void)
+{
+    return dma.clock;
+}
+
+static void fakeDmaWrite(uint32_t us)
+{
+    IR_Generator_DmaWrite(&dma, us);
+}
+
+#ifdef IR_DECODER_DUAL_RING
+static uint32_t fakeRisingRemaining(void)
+{
+    return IR_Generator_DmaRisingRemaining(&dma);
+}
+
+static void fakeDualWrite(uint32_t us)
+{
+    IR_Generator_DmaDualWrite(&dma, us);
+}
+
+static void fakeDualDrop(uint32_t us)
+{
+    IR_Generator_DmaAdvance(&dma, us);
+    dma.nextRising = !dma.nextRising;
+}
+
+static void useDualRing(void)
+{
+    writeEdge = &fakeDualWrite;
+    decoder.risingBuffer = risingData;
+    decoder.risingRemaining = &fakeRisingRemaining;
+    IR_Decoder_Init(&decoder);
+}
+#endif
+
+#ifdef IR_DECODER_CARRIER
+static void fakeCarrierWrite(uint32_t us)
+{
+    uint32_t cycles = us / 26 ? us / 26 : 1;
+
+    // a space is written as the edge starting the next burst, decoding often enough to keep up
+    if (!carrierMark)
+    {
+        fakeDmaWrite(us + carrierLeft);
+        carrierMark = 1;
+        return;
+    }
+
+    // whole 26us cycles on for 9us, the mark ends with the last one turning off
+    for (uint32_t cycle = 0; cycle < cycles; cycle++)
+    {
+        if (cycle)
+        {
+            fakeDmaWrite(17);
+        }
+        fakeDmaWrite(9);
+        if (dma.index % 32 == 0)
+        {
+            IR_Decoder_Decode(&decoder);
+        }
+    }
+    carrierLeft = us - (cycles - 1) * 26 - 9;
+    carrierMark = 0;
+}
+#endif
+
+static void fakeDmaFrame(uint8_t address, uint8_t command)
+{
+    uint32_t edges[IR_ENCODER_FRAME_EDGES];
+
+    // idle gap then the encoded frame
+    fakeEncoded(frameGap, edges, IR_Encoder_Frame(&encoder, address, command, edges));
+}
+
+static void fakeDmaRepeat(void)
+{
+    uint32_t edges[IR_ENCODER_REPEAT_EDGES];
+
+    fakeEncoded(40000, edges, IR_Encoder_Repeat(&encoder, edges));
+}
+
+static void fakeEncoded(uint32_t gap, const uint32_t *edges, uint8_t count)
+{
+    IR_Generator_Widths(edges, count, encoder.period, gap, writeEdge);
+}
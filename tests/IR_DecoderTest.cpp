@@ -1,6 +1,7 @@
 extern "C"
 {
 #include "IR_Decoder.h"
+#include "IR_Generator.h"
 
 #include <string.h>
 }
@@ -11,14 +12,24 @@ extern "C"
 #define CLOCK_SPEED_MHZ 84
 #define PERIOD          8400000
 
+// carrier edges of a frame
+#define CARRIER_EDGES   2400
+
 
 static uint32_t data[BUFFER_SIZE];
 static IR_Decoder_t *pDecoder;
 static IR_Message_t *pMessage;
 static uint8_t decodedCommand;
 static uint8_t repeatCommand;
+#ifdef IR_DECODER_TRACE
+static uint64_t traceClock;
+#endif
 
 static void decodeFinished_callback(IR_Message_t *pMessage);
+static void contextFinished_callback(void *context, IR_Message_t *pMessage);
+#ifdef IR_DECODER_TRACE
+static uint64_t fakeTraceTime(void);
+#endif
 
 TEST_GROUP(IR_Decoder)
 {
@@ -28,6 +39,7 @@ TEST_GROUP(IR_Decoder)
         repeatCommand = 0;
         pDecoder = (IR_Decoder_t*)malloc(sizeof(IR_Decoder_t));
         pMessage = (IR_Message_t*)malloc(sizeof(IR_Message_t));
+        IR_Decoder_ConfigDefaults(pDecoder);
         pDecoder->buffer = data;
         pDecoder->bufferSize = BUFFER_SIZE;
         pDecoder->clockSpeed = CLOCK_SPEED_MHZ;
@@ -63,22 +75,87 @@ TEST(IR_Decoder, Init)
 
     memset(data, 0xFFFFFFFF, sizeof(data));
 
+    IR_Decoder_ConfigDefaults(&decoder);
     decoder.buffer = data;
     decoder.bufferSize = BUFFER_SIZE;
     decoder.state = Address;
     decoder.currentIndex = 0xFF;
     decoder.pulseNumber = 1;
+    decoder.frame = 0x12345678;
+    decoder.frameError = 0x9ABCDEF0;
     decoder.clockSpeed = CLOCK_SPEED_MHZ;
     decoder.period = PERIOD;
     decoder.message = &message;
     decoder.decodeCallback = &decodeFinished_callback;
     decoder.clearLast = 0xFF;
+#ifdef IR_DECODER_DUAL_RING
+    decoder.risingIndex = 0xFF;
+    decoder.risingWriteIndex = 0xFF;
+    decoder.risingCaptureWraps = 0xFF;
+    decoder.risingReadWraps = 0xFF;
+#endif
+    decoder.writeIndex = 0xFF;
+    decoder.captureWraps = 0xFF;
+    decoder.readWraps = 0xFF;
+    decoder.overruns = 0xFF;
+    decoder.quietDecodes = 0xFF;
+    decoder.duplicates = 0xFF;
+    decoder.timeouts = 0xFF;
+    decoder.sinceFrame = 0xFF;
+    decoder.lastFrame = 0xFF;
+    decoder.hasTrailingEdge = 0xFF;
+    decoder.lastEdge = 0xFF;
+    decoder.markTime = 0xFF;
+    decoder.hasLastEdge = 0xFF;
+    decoder.hasMark = 0xFF;
+#ifdef IR_DECODER_SAMPLES
+    decoder.sampleRun = 0xFF;
+    decoder.sampleLevel = 0xFF;
+    decoder.sampleRemainder = 0xFF;
+#endif
+#ifdef IR_DECODER_CARRIER
+    decoder.carrierBurst = 0xFF;
+    decoder.carrierOff = 0xFF;
+    decoder.carrierLast = 0xFF;
+#endif
 
     IR_Decoder_Init(&decoder);
     BYTES_EQUAL(0, decoder.currentIndex);
     BYTES_EQUAL(0, decoder.pulseNumber);
+    LONGLONGS_EQUAL(0, decoder.frame);
+    LONGLONGS_EQUAL(0, decoder.frameError);
     BYTES_EQUAL(CLOCK_SPEED_MHZ, decoder.clockSpeed);
     BYTES_EQUAL(0, decoder.clearLast);
+    BYTES_EQUAL(0, decoder.writeIndex);
+    LONGS_EQUAL(0, decoder.captureWraps);
+    LONGS_EQUAL(0, decoder.readWraps);
+    LONGS_EQUAL(0, decoder.overruns);
+    LONGS_EQUAL(0, decoder.quietDecodes);
+    LONGS_EQUAL(0, decoder.duplicates);
+    LONGS_EQUAL(0, decoder.timeouts);
+    LONGLONGS_EQUAL(UINT32_MAX, decoder.sinceFrame);
+    LONGLONGS_EQUAL(0, decoder.lastFrame);
+    BYTES_EQUAL(0, decoder.hasTrailingEdge);
+    LONGLONGS_EQUAL(0, decoder.lastEdge);
+    LONGLONGS_EQUAL(0, decoder.markTime);
+    BYTES_EQUAL(0, decoder.hasLastEdge);
+    BYTES_EQUAL(0, decoder.hasMark);
+#ifdef IR_DECODER_DUAL_RING
+    BYTES_EQUAL(0, decoder.risingIndex);
+    BYTES_EQUAL(0, decoder.risingWriteIndex);
+    LONGS_EQUAL(0, decoder.risingCaptureWraps);
+    LONGS_EQUAL(0, decoder.risingReadWraps);
+#endif
+#ifdef IR_DECODER_SAMPLES
+    LONGLONGS_EQUAL(0, decoder.sampleRun);
+    BYTES_EQUAL(1, decoder.sampleLevel);
+    LONGS_EQUAL(0, decoder.sampleRemainder);
+#endif
+#ifdef IR_DECODER_CARRIER
+    LONGLONGS_EQUAL(0, decoder.carrierBurst);
+    LONGLONGS_EQUAL(0, decoder.carrierOff);
+    LONGLONGS_EQUAL(0, decoder.carrierLast);
+#endif
     LONGLONGS_EQUAL(PERIOD, decoder.period);
     CHECK(decoder.state == LeadIn);
     CHECK(decoder.message == &message);
@@ -172,11 +249,12 @@ TEST(IR_Decoder, Decode_InvalidLeadIn)
     data[2] = 3844152;
     IR_Decoder_Decode(pDecoder);
  
-    BYTES_EQUAL(2, pDecoder->currentIndex);
+    // only the first edge is dropped, the next one may still start a lead-in
+    BYTES_EQUAL(1, pDecoder->currentIndex);
     BYTES_EQUAL(0, pDecoder->pulseNumber);
     CHECK(pDecoder->state == LeadIn);
     LONGLONGS_EQUAL(0, pDecoder->buffer[0]);
-    LONGLONGS_EQUAL(0, pDecoder->buffer[1]);
+    LONGLONGS_EQUAL(2462448, pDecoder->buffer[1]);
 }
 
 
@@ -222,8 +300,8 @@ TEST(IR_Decoder, Decode_Address)
     IR_Decoder_Decode(pDecoder);
 
     BYTES_EQUAL(18, pDecoder->currentIndex);
-    BYTES_EQUAL(0, pDecoder->pulseNumber);
-    BYTES_EQUAL(0, pDecoder->message->address);
+    BYTES_EQUAL(8, pDecoder->pulseNumber);
+    BYTES_EQUAL(0, pDecoder->frame);
     CHECK(pDecoder->state == AddressInv);
 }
 
@@ -252,8 +330,8 @@ TEST(IR_Decoder, Decode_AddressNonZero)
     IR_Decoder_Decode(pDecoder);
 
     BYTES_EQUAL(16, pDecoder->currentIndex);
-    BYTES_EQUAL(0, pDecoder->pulseNumber);
-    BYTES_EQUAL(0xF2, pDecoder->message->address);
+    BYTES_EQUAL(8, pDecoder->pulseNumber);
+    BYTES_EQUAL(0xF2, pDecoder->frame);
     CHECK(pDecoder->state == AddressInv);
 
     for (int i = 0; i < 16; i++)
@@ -266,6 +344,7 @@ TEST(IR_Decoder, Decode_InvAddress)
 {
     pDecoder->currentIndex = 19;
     pDecoder->state = AddressInv;
+    pDecoder->pulseNumber = 8;
 
     data[19] = 4213821;
     data[20] = 4258903;
@@ -287,14 +366,15 @@ TEST(IR_Decoder, Decode_InvAddress)
     IR_Decoder_Decode(pDecoder);
 
     BYTES_EQUAL(35, pDecoder->currentIndex);
-    BYTES_EQUAL(0, pDecoder->pulseNumber);
-    BYTES_EQUAL(0x0D, pDecoder->message->addressInv);
+    BYTES_EQUAL(16, pDecoder->pulseNumber);
+    BYTES_EQUAL(0x0D, pDecoder->frame >> 8);
     CHECK(pDecoder->state == Command);
 }
 
 TEST(IR_Decoder, Decode_Command)
 {
     pDecoder->state = Command;
+    pDecoder->pulseNumber = 16;
 
     data[0] = 4213962;
     data[1] = 4260887;
@@ -317,15 +397,16 @@ TEST(IR_Decoder, Decode_Command)
     IR_Decoder_Decode(pDecoder);
 
     BYTES_EQUAL(16, pDecoder->currentIndex);
-    BYTES_EQUAL(0, pDecoder->pulseNumber);
-    BYTES_EQUAL(0xE7, pDecoder->message->command);
+    BYTES_EQUAL(24, pDecoder->pulseNumber);
+    BYTES_EQUAL(0xE7, pDecoder->frame >> 16);
     CHECK(pDecoder->state == CommandInv);
 }
 
 TEST(IR_Decoder, Decode_CommandInv)
 {
     pDecoder->state = CommandInv;
-    pDecoder->message->command = 0x16;
+    pDecoder->pulseNumber = 24;
+    pDecoder->frame = 0x16 << 16;
 
     data[0] = 2916332;
     data[1] = 2965982;
@@ -366,6 +447,8 @@ TEST(IR_Decoder, RepeatCommand)
 
     BYTES_EQUAL(0x9E, decodedCommand);
     BYTES_EQUAL(1, repeatCommand);
+    LONGLONGS_EQUAL(7309478, pMessage->firstEdge);
+    LONGLONGS_EQUAL(8260597, pMessage->lastEdge);
     BYTES_EQUAL(4, pDecoder->currentIndex);
     CHECK(pDecoder->state == LeadIn);
     for (int i = 0; i < 4; i++)
@@ -524,6 +607,7 @@ TEST(IR_Decoder, BadAddressSignal)
 {
     pDecoder->currentIndex = 50;
     pDecoder->state = Address;
+    pDecoder->pulseNumber = 0;
 
     data[50] = 674816;
     data[51] = 714818;
@@ -546,16 +630,17 @@ TEST(IR_Decoder, BadAddressSignal)
     IR_Decoder_Decode(pDecoder);
 
     CHECK(pDecoder->state == AddressInv);
-    BYTES_EQUAL(0, pDecoder->pulseNumber);
+    BYTES_EQUAL(8, pDecoder->pulseNumber);
     BYTES_EQUAL(66, pDecoder->currentIndex);
-    BYTES_EQUAL(0xA2, pDecoder->message->address);
-    BYTES_EQUAL(0x1D, pDecoder->message->addressError);
+    BYTES_EQUAL(0xA2, pDecoder->frame);
+    BYTES_EQUAL(0x1D, pDecoder->frameError);
 }
 
 TEST(IR_Decoder, BadAddressInvSignal)
 {
     pDecoder->currentIndex = 34;
     pDecoder->state = AddressInv;
+    pDecoder->pulseNumber = 8;
 
     data[34] = 8115750;
     data[35] = 8160433;
@@ -578,16 +663,17 @@ TEST(IR_Decoder, BadAddressInvSignal)
     IR_Decoder_Decode(pDecoder);
 
     CHECK(pDecoder->state == Command);
-    BYTES_EQUAL(0, pDecoder->pulseNumber);
+    BYTES_EQUAL(16, pDecoder->pulseNumber);
     BYTES_EQUAL(50, pDecoder->currentIndex);
-    BYTES_EQUAL(0x44, pDecoder->message->addressInv);
-    BYTES_EQUAL(0xB8, pDecoder->message->addressInvError);
+    BYTES_EQUAL(0x44, pDecoder->frame >> 8);
+    BYTES_EQUAL(0xB8, pDecoder->frameError >> 8);
 }
 
 TEST(IR_Decoder, BadCommandSignal)
 {
     pDecoder->currentIndex = 18;
     pDecoder->state = Command;
+    pDecoder->pulseNumber = 16;
 
     data[18] = 6586529;
     data[19] = 6625051;
@@ -610,16 +696,17 @@ TEST(IR_Decoder, BadCommandSignal)
     IR_Decoder_Decode(pDecoder);
 
     CHECK(pDecoder->state == CommandInv);
-    BYTES_EQUAL(0, pDecoder->pulseNumber);
+    BYTES_EQUAL(24, pDecoder->pulseNumber);
     BYTES_EQUAL(34, pDecoder->currentIndex);
-    BYTES_EQUAL(0xD8, pDecoder->message->command);
-    BYTES_EQUAL(0x27, pDecoder->message->commandError);
+    BYTES_EQUAL(0xD8, pDecoder->frame >> 16);
+    BYTES_EQUAL(0x27, pDecoder->frameError >> 16);
 }
 
 TEST(IR_Decoder, BadCommandInvSignal)
 {
     pDecoder->currentIndex = 18;
     pDecoder->state = CommandInv;
+    pDecoder->pulseNumber = 24;
 
     data[18] = 4624934;
     data[19] = 4662240;
@@ -737,7 +824,7 @@ TEST(IR_Decoder, MissingFinalValue)
 {
     pDecoder->state = CommandInv;
     pDecoder->currentIndex = 14;
-    pDecoder->pulseNumber = 7;
+    pDecoder->pulseNumber = 31;
 
     data[14] = 3967833;
     data[15] = 4015342;
@@ -760,7 +847,7 @@ TEST(IR_Decoder, MissingFinalValueBoundary)
 {
     pDecoder->state = CommandInv;
     pDecoder->currentIndex = BUFFER_SIZE - 4;
-    pDecoder->pulseNumber = 7;
+    pDecoder->pulseNumber = 31;
 
     data[BUFFER_SIZE - 4] = 3967833;
     data[BUFFER_SIZE - 3] = 4015342;
@@ -777,6 +864,717 @@ TEST(IR_Decoder, MissingFinalValueBoundary)
     LONGLONGS_EQUAL(759617, pDecoder->buffer[0]);
 }
 
+TEST(IR_Decoder, LeadInWindowBounds)
+{
+    // 8750us mark sits on the exclusive lower bound and is rejected
+    data[0] = 100000;
+    data[1] = 100000 + 8750 * CLOCK_SPEED_MHZ;
+    data[2] = data[1] + 4500 * CLOCK_SPEED_MHZ;
+
+    IR_Decoder_Decode(pDecoder);
+    CHECK(pDecoder->state == LeadIn);
+
+    // 8751us mark and 4749us space are the widest accepted lead-in
+    data[2] = 1000000;
+    data[3] = 1000000 + 8751 * CLOCK_SPEED_MHZ;
+    data[4] = data[3] + 4749 * CLOCK_SPEED_MHZ;
+
+    IR_Decoder_Decode(pDecoder);
+    CHECK(pDecoder->state == Address);
+}
+
+TEST(IR_Decoder, BitWindowBounds)
+{
+    pDecoder->state = Address;
+
+    // 501us mark + 1799us space is a one, 600us mark is outside the short window
+    data[0] = 100000;
+    data[1] = data[0] + 501 * CLOCK_SPEED_MHZ;
+    data[2] = data[1] + 1799 * CLOCK_SPEED_MHZ;
+    data[3] = data[2] + 600 * CLOCK_SPEED_MHZ;
+    data[4] = data[3] + 560 * CLOCK_SPEED_MHZ;
+
+    IR_Decoder_Decode(pDecoder);
+
+    BYTES_EQUAL(2, pDecoder->pulseNumber);
+    BYTES_EQUAL(0x01, pDecoder->frame);
+    BYTES_EQUAL(0x02, pDecoder->frameError);
+}
+
+TEST(IR_Decoder, Timestamps)
+{
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 0x123456789ULL, 0x00, 0x16, times);
+
+    // split mid pair, the stream carries over between calls
+    IR_Decoder_DecodeTimestamps(pDecoder, times, 31);
+    CHECK(pDecoder->state == AddressInv);
+    IR_Decoder_DecodeTimestamps(pDecoder, &times[31], count - 31);
+
+    BYTES_EQUAL(0x16, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+    CHECK(pDecoder->state == LeadIn);
+    BYTES_EQUAL(0, repeatCommand);
+    // the lead-in was taken in the first call, the frame ends with the start of the stop mark
+    LONGLONGS_EQUAL(0x123456789ULL, pMessage->firstEdge);
+    LONGLONGS_EQUAL(times[count - 2], pMessage->lastEdge);
+
+    // repeat 108ms after the frame started
+    times[0] = times[0] + 108000 * CLOCK_SPEED_MHZ;
+    times[1] = times[0] + 9000 * CLOCK_SPEED_MHZ;
+    times[2] = times[1] + 2500 * CLOCK_SPEED_MHZ;
+    times[3] = times[2] + 560 * CLOCK_SPEED_MHZ;
+    IR_Decoder_DecodeTimestamps(pDecoder, times, 4);
+
+    BYTES_EQUAL(1, repeatCommand);
+    LONGLONGS_EQUAL(times[0], pMessage->firstEdge);
+    LONGLONGS_EQUAL(times[2], pMessage->lastEdge);
+}
+
+TEST(IR_Decoder, TimestampsMultiWrapGap)
+{
+    // a 9ms mark then a space two timer periods longer than a lead-in space
+    uint32_t gap = 2 * PERIOD + 4500 * CLOCK_SPEED_MHZ;
+    uint64_t times[] = { 1000, 1000 + 9000 * CLOCK_SPEED_MHZ, 1000 + 9000 * CLOCK_SPEED_MHZ + (uint64_t)gap };
+
+    IR_Decoder_DecodeTimestamps(pDecoder, times, 3);
+    CHECK(pDecoder->state == LeadIn);
+
+    // the same edges wrapped to 32 bit captures alias to a lead-in
+    data[0] = times[0] % PERIOD;
+    data[1] = times[1] % PERIOD;
+    data[2] = times[2] % PERIOD;
+    IR_Decoder_Decode(pDecoder);
+    CHECK(pDecoder->state == Address);
+}
+
+TEST(IR_Decoder, ExtendCapture)
+{
+    LONGLONGS_EQUAL(3ULL * PERIOD + 500, IR_Decoder_ExtendCapture(pDecoder, 500, 3, 0));
+    // captured just after the wrap, the update interrupt is still pending
+    LONGLONGS_EQUAL(4ULL * PERIOD + 500, IR_Decoder_ExtendCapture(pDecoder, 500, 3, 1));
+    // captured just before the wrap
+    LONGLONGS_EQUAL(3ULL * PERIOD + PERIOD - 500, IR_Decoder_ExtendCapture(pDecoder, PERIOD - 500, 3, 1));
+}
+
+TEST(IR_Decoder, ExtendedCapturesDecode)
+{
+    uint64_t times[72];
+    uint16_t count;
+
+    // a 250ms idle gap wraps the timer twice before the frame
+    times[0] = IR_Decoder_ExtendCapture(pDecoder, 1000, 0, 0);
+    times[1] = IR_Decoder_ExtendCapture(pDecoder, 1000 + 560 * CLOCK_SPEED_MHZ, 0, 0);
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, times[1] + 250000ULL * CLOCK_SPEED_MHZ,
+                                    0x00, 0x42, &times[2]);
+    for (uint16_t i = 2; i < count + 2; i++)
+    {
+        times[i] = IR_Decoder_ExtendCapture(pDecoder, times[i] % PERIOD, times[i] / PERIOD, 0);
+    }
+
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count + 2);
+    BYTES_EQUAL(0x42, decodedCommand);
+}
+
+#ifdef IR_DECODER_DURATIONS
+TEST(IR_Decoder, Durations)
+{
+    uint64_t times[72];
+    uint32_t captures[72];
+    uint16_t durations[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, PERIOD - 20000 * CLOCK_SPEED_MHZ, 0x00, 0x5A, times);
+
+    // the frame straddles a timer wrap
+    for (uint16_t i = 0; i < count; i++)
+    {
+        captures[i] = times[i] % PERIOD;
+    }
+
+    LONGS_EQUAL(count - 1, IR_Decoder_ToDurations(pDecoder, captures, count, durations));
+    LONGS_EQUAL(9000, durations[0]);
+    LONGS_EQUAL(4500, durations[1]);
+
+    IR_Decoder_DecodeDurations(pDecoder, durations, 21);
+    CHECK(pDecoder->state == AddressInv);
+    IR_Decoder_DecodeDurations(pDecoder, &durations[21], count - 22);
+    BYTES_EQUAL(0x5A, decodedCommand);
+    CHECK(pDecoder->state == LeadIn);
+
+    // an idle gap longer than a uint16_t is clamped
+    captures[1] = captures[0] + 70000 * CLOCK_SPEED_MHZ;
+    IR_Decoder_ToDurations(pDecoder, captures, 2, durations);
+    LONGS_EQUAL(UINT16_MAX, durations[0]);
+    LONGS_EQUAL(0, IR_Decoder_ToDurations(pDecoder, captures, 0, durations));
+}
+#endif
+
+TEST(IR_Decoder, Create)
+{
+    static uint8_t block[IR_DECODER_SIZE(BUFFER_SIZE) + 1];
+    IR_Decoder_t *decoder;
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x6B, times);
+
+    LONGS_EQUAL(IR_DECODER_SIZE(BUFFER_SIZE), IR_Decoder_Size(BUFFER_SIZE));
+
+    // an odd start address is aligned within the block
+    decoder = IR_Decoder_Create(&block[1], sizeof(block) - 1, BUFFER_SIZE, CLOCK_SPEED_MHZ, PERIOD,
+                                &decodeFinished_callback);
+    CHECK(decoder);
+    LONGS_EQUAL(0, (uintptr_t)decoder % IR_DECODER_CACHE_LINE);
+    LONGS_EQUAL(0, (uintptr_t)decoder->buffer % IR_DECODER_CACHE_LINE);
+    CHECK((uint8_t *)decoder->message >= (uint8_t *)(decoder + 1));
+    CHECK((uint8_t *)(decoder->message + 1) <= (uint8_t *)decoder->buffer);
+    CHECK((uint8_t *)(decoder->buffer + BUFFER_SIZE) <= block + sizeof(block));
+    BYTES_EQUAL(BUFFER_SIZE, decoder->bufferSize);
+    BYTES_EQUAL(CLOCK_SPEED_MHZ, decoder->clockSpeed);
+    LONGS_EQUAL(PERIOD, decoder->period);
+    CHECK(decoder->state == LeadIn);
+    POINTERS_EQUAL(NULL, decoder->captureRemaining);
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        decoder->buffer[i] = times[i] % PERIOD;
+    }
+    IR_Decoder_Decode(decoder);
+    BYTES_EQUAL(0x6B, decodedCommand);
+    BYTES_EQUAL(0x6B, decoder->message->command);
+}
+
+TEST(IR_Decoder, ConfigDefaults)
+{
+    IR_Decoder_t decoder;
+    IR_Message_t message;
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x6C, times);
+
+    // a stack decoder starts out as garbage, only the fields set here are used
+    memset(&decoder, 0xA5, sizeof(decoder));
+    IR_Decoder_ConfigDefaults(&decoder);
+    decoder.clockSpeed = CLOCK_SPEED_MHZ;
+    decoder.message = &message;
+    decoder.decodeCallback = &decodeFinished_callback;
+    IR_Decoder_Init(&decoder);
+
+    POINTERS_EQUAL(NULL, decoder.captureRemaining);
+    POINTERS_EQUAL(NULL, decoder.contextCallback);
+#ifdef IR_DECODER_RECORDER
+    POINTERS_EQUAL(NULL, decoder.recorder);
+#endif
+#ifdef IR_DECODER_DURATIONS
+    POINTERS_EQUAL(NULL, decoder.durationBuffer);
+#endif
+#ifdef IR_DECODER_DUAL_RING
+    POINTERS_EQUAL(NULL, decoder.risingBuffer);
+#endif
+#ifdef IR_DECODER_CARRIER
+    LONGS_EQUAL(0, decoder.carrierGap);
+#endif
+    LONGS_EQUAL(0, decoder.duplicateWindow);
+    IR_Decoder_DecodeTimestamps(&decoder, times, count);
+    BYTES_EQUAL(0x6C, decodedCommand);
+}
+
+TEST(IR_Decoder, CreateTooSmall)
+{
+    static uint8_t block[IR_DECODER_SIZE(BUFFER_SIZE)];
+
+    POINTERS_EQUAL(NULL, IR_Decoder_Create(block, sizeof(block) - 1, BUFFER_SIZE, CLOCK_SPEED_MHZ, PERIOD, NULL));
+    POINTERS_EQUAL(NULL, IR_Decoder_Create(NULL, sizeof(block), BUFFER_SIZE, CLOCK_SPEED_MHZ, PERIOD, NULL));
+    // without a ring only the timestamp and duration inputs are usable
+    CHECK(IR_Decoder_Create(block, IR_Decoder_Size(0), 0, CLOCK_SPEED_MHZ, PERIOD, NULL));
+}
+
+TEST(IR_Decoder, DuplicateGapLongerThanPeriod)
+{
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x1D, times);
+
+    pDecoder->duplicateWindow = 20000;
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+
+    // 5ms after the last frame is a duplicate, the gap is timed from its final bit so includes the stop mark
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, times[count - 1] + 5000 * CLOCK_SPEED_MHZ, 0x00, 0x1D, times);
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    LONGS_EQUAL(1, pDecoder->duplicates);
+    LONGS_EQUAL(550 + 5000, pDecoder->leadInGap);
+
+    // a period and 5ms after is not, monotonic timestamps do not wrap
+    decodedCommand = 0;
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, times[count - 1] + PERIOD + 5000 * CLOCK_SPEED_MHZ,
+                                    0x00, 0x1D, times);
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    BYTES_EQUAL(0x1D, decodedCommand);
+    LONGS_EQUAL(1, pDecoder->duplicates);
+    LONGS_EQUAL(550 + PERIOD / CLOCK_SPEED_MHZ + 5000, pDecoder->leadInGap);
+}
+
+#ifdef IR_DECODER_QUALITY
+TEST(IR_Decoder, SignalQuality)
+{
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x16, times);
+
+    // encoded widths sit on nominal
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    LONGS_EQUAL(0, pMessage->meanDeviation);
+    LONGS_EQUAL(0, pMessage->maxDeviation);
+
+    // one slow one space, still a valid bit
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000 + 108000 * CLOCK_SPEED_MHZ, 0x00, 0x16, times);
+    for (uint16_t i = 40; i < count; i++)
+    {
+        times[i] += 100 * CLOCK_SPEED_MHZ;
+    }
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    BYTES_EQUAL(0x16, decodedCommand);
+    LONGS_EQUAL(0, pMessage->commandError);
+    LONGS_EQUAL(100 / 66, pMessage->meanDeviation);
+    LONGS_EQUAL(100, pMessage->maxDeviation);
+}
+
+TEST(IR_Decoder, SignalQualityFollowsProfile)
+{
+    IR_Timing_t shifted;
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x16, times);
+
+    // a short window centred on 560us, the encoded 550us marks and zero spaces are 10us off
+    IR_Timing_Default(&shifted);
+    shifted.shortLow = 520;
+    CHECK(IR_Timing_Build(&shifted));
+    IR_Decoder_SetTiming(pDecoder, &shifted);
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+
+    BYTES_EQUAL(0x16, decodedCommand);
+    LONGS_EQUAL(10, pMessage->maxDeviation);
+    LONGS_EQUAL((32 + 16) * 10 / 66, pMessage->meanDeviation);
+}
+#endif
+
+TEST(IR_Decoder, EdgeTimeout)
+{
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x51, times);
+
+    // interference cut the frame short after 13 bits
+    IR_Decoder_DecodeTimestamps(pDecoder, times, 30);
+    CHECK(pDecoder->state == AddressInv);
+
+    // the next keypress is not corrupted by the leftover bits
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000 + 200000 * CLOCK_SPEED_MHZ, 0x00, 0x52, times);
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    BYTES_EQUAL(0x52, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+    LONGS_EQUAL(1, pDecoder->timeouts);
+
+    // a repeat after an abandoned frame has nothing to repeat
+    IR_Generator_Timestamps(CLOCK_SPEED_MHZ, times[count - 1] + 40000 * CLOCK_SPEED_MHZ, 0x00, 0x53, times);
+    IR_Decoder_DecodeTimestamps(pDecoder, times, 20);
+    times[0] = times[19] + 30000 * CLOCK_SPEED_MHZ;
+    times[1] = times[0] + 9000 * CLOCK_SPEED_MHZ;
+    times[2] = times[1] + 2500 * CLOCK_SPEED_MHZ;
+    times[3] = times[2] + 560 * CLOCK_SPEED_MHZ;
+    IR_Decoder_DecodeTimestamps(pDecoder, times, 4);
+    LONGS_EQUAL(2, pDecoder->timeouts);
+    BYTES_EQUAL(0, repeatCommand);
+    CHECK(pDecoder->state == Resync);
+}
+
+TEST(IR_Decoder, SeekRealignsAfterStrayEdge)
+{
+    uint64_t times[72];
+    uint16_t count;
+
+    // a glitch 3ms before the lead-in puts the whole frame on the other edge parity
+    times[0] = 1000;
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000 + 3000 * CLOCK_SPEED_MHZ, 0x00, 0x3D, &times[1]) + 1;
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    BYTES_EQUAL(0x3D, decodedCommand);
+
+    // the same edges through the capture ring
+    decodedCommand = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        data[i] = times[i];
+    }
+    IR_Decoder_Decode(pDecoder);
+    BYTES_EQUAL(0x3D, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+}
+
+#ifdef IR_DECODER_SAMPLES
+TEST(IR_Decoder, SampledBitmap)
+{
+    uint64_t times[72];
+    uint32_t samples[6000];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x29, times);
+    uint16_t words;
+
+    // 50kHz, the runs are within a sample of the captured widths
+    words = IR_Generator_Samples(CLOCK_SPEED_MHZ, times, count, 20000, samples);
+    IR_Decoder_DecodeSamples(pDecoder, samples, words, 20000);
+
+    BYTES_EQUAL(0x29, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+}
+
+TEST(IR_Decoder, SampledBitmapAcrossCalls)
+{
+    uint64_t times[144];
+    uint32_t samples[6000];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x2A, times);
+    uint16_t words;
+
+    count += IR_Generator_Timestamps(CLOCK_SPEED_MHZ, times[count - 1] + 40000 * CLOCK_SPEED_MHZ,
+                                     0x00, 0x2B, &times[count]);
+    words = IR_Generator_Samples(CLOCK_SPEED_MHZ, times, count, 10000, samples);
+
+    // a word at a time, runs carry over between calls
+    for (uint16_t i = 0; i < words; i++)
+    {
+        IR_Decoder_DecodeSamples(pDecoder, &samples[i], 1, 10000);
+        if (i == words / 2)
+        {
+            BYTES_EQUAL(0x2A, decodedCommand);
+        }
+    }
+
+    BYTES_EQUAL(0x2B, decodedCommand);
+    BYTES_EQUAL(0, pMessage->commandError);
+}
+
+TEST(IR_Decoder, SampledBitmapBackToBack)
+{
+    uint64_t times[72];
+    static uint32_t samples[6000];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x2C, times);
+    uint16_t words = IR_Generator_Samples(CLOCK_SPEED_MHZ, times, count, 20000, samples);
+    uint16_t decoded = 0;
+
+    // the same buffer again, the trailing idle word ends each frame before the next lead-in
+    for (uint16_t i = 0; i < 3; i++)
+    {
+        decodedCommand = 0;
+        IR_Decoder_DecodeSamples(pDecoder, samples, words, 20000);
+        decoded += decodedCommand == 0x2C;
+    }
+
+    LONGS_EQUAL(3, decoded);
+}
+#endif
+
+#ifdef IR_DECODER_CARRIER
+TEST(IR_Decoder, CarrierTimestamps)
+{
+    uint64_t times[72];
+    static uint64_t carrier[CARRIER_EDGES];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x3A, times);
+    uint16_t edges = IR_Generator_Carrier(CLOCK_SPEED_MHZ, times, count, carrier);
+
+    pDecoder->carrierGap = 100;
+
+    // every mark arrives as a burst of carrier edges
+    IR_Decoder_DecodeTimestamps(pDecoder, carrier, edges / 2);
+    BYTES_EQUAL(0, decodedCommand);
+    IR_Decoder_DecodeTimestamps(pDecoder, &carrier[edges / 2], edges - edges / 2);
+
+    BYTES_EQUAL(0x3A, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+    // from the first cycle of the lead-in to the first cycle of the stop mark
+    LONGLONGS_EQUAL(times[0], pMessage->firstEdge);
+    LONGLONGS_EQUAL(times[count - 2], pMessage->lastEdge);
+
+    // a repeat 40ms after the final bit
+    times[0] = carrier[edges - 1] + 40000 * CLOCK_SPEED_MHZ;
+    times[1] = times[0] + 9000 * CLOCK_SPEED_MHZ;
+    times[2] = times[1] + 2250 * CLOCK_SPEED_MHZ;
+    times[3] = times[2] + 560 * CLOCK_SPEED_MHZ;
+    times[4] = times[3] + 40000 * CLOCK_SPEED_MHZ;
+    edges = IR_Generator_Carrier(CLOCK_SPEED_MHZ, times, 4, carrier);
+
+    // the burst of the final mark only ends with the next edge
+    carrier[edges++] = times[4];
+    decodedCommand = 0;
+    IR_Decoder_DecodeTimestamps(pDecoder, carrier, edges);
+    BYTES_EQUAL(0x3A, decodedCommand);
+    BYTES_EQUAL(1, repeatCommand);
+}
+
+TEST(IR_Decoder, CarrierRingWithoutDmaPosition)
+{
+    uint64_t times[72];
+    static uint64_t carrier[CARRIER_EDGES];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x3D, times);
+    uint16_t edges = IR_Generator_Carrier(CLOCK_SPEED_MHZ, times, count, carrier);
+    uint8_t writeIndex = 0;
+
+    // new captures are told apart by being non-zero, written a chunk at a time between decodes
+    carrier[edges] = carrier[edges - 1] + 40000 * CLOCK_SPEED_MHZ;
+    edges++;
+    pDecoder->carrierGap = 100;
+    IR_Decoder_Init(pDecoder);
+    for (uint16_t i = 0; i < edges; i++)
+    {
+        data[writeIndex] = carrier[i] % PERIOD;
+        writeIndex = (writeIndex + 1) % BUFFER_SIZE;
+        if (i % 64 == 63 || i == edges - 1)
+        {
+            IR_Decoder_Decode(pDecoder);
+        }
+    }
+
+    BYTES_EQUAL(0x3D, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+    LONGS_EQUAL(0, data[(writeIndex + BUFFER_SIZE - 1) % BUFFER_SIZE]);
+}
+#endif
+
+#if defined(IR_DECODER_SAMPLES) && defined(IR_DECODER_CARRIER)
+TEST(IR_Decoder, CarrierSamples)
+{
+    uint64_t times[72];
+    static uint64_t carrier[CARRIER_EDGES];
+    static uint32_t samples[2000];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x3B, times);
+    uint16_t edges = IR_Generator_Carrier(CLOCK_SPEED_MHZ, times, count, carrier);
+    uint16_t words = IR_Generator_Samples(CLOCK_SPEED_MHZ, carrier, edges, 2000, samples);
+
+    // 500kHz sampling catches every carrier cycle
+    pDecoder->carrierGap = 100;
+    IR_Decoder_DecodeSamples(pDecoder, samples, words, 2000);
+
+    BYTES_EQUAL(0x3B, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+}
+#endif
+
+#ifdef IR_DECODER_CARRIER
+TEST(IR_Decoder, CarrierBackToBack)
+{
+    uint64_t times[72];
+    static uint64_t carrier[CARRIER_EDGES];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x3C, times);
+    uint16_t edges = IR_Generator_Carrier(CLOCK_SPEED_MHZ, times, count, carrier);
+    uint16_t decoded = 0;
+
+    // the edge after the frame closes its last burst
+    carrier[edges] = carrier[edges - 1] + 40000 * CLOCK_SPEED_MHZ;
+    edges++;
+    pDecoder->carrierGap = 100;
+    IR_Decoder_Init(pDecoder);
+    for (uint16_t i = 0; i < 3; i++)
+    {
+        // each pass restarts from an idle gap
+        decodedCommand = 0;
+        pDecoder->hasLastEdge = 0;
+        IR_Decoder_DecodeTimestamps(pDecoder, carrier, edges);
+        decoded += decodedCommand == 0x3C;
+    }
+
+    LONGS_EQUAL(3, decoded);
+}
+#endif
+
+TEST(IR_Decoder, BoundedDecode)
+{
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x2C, times);
+    uint8_t calls = 0;
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        data[i] = times[i] % PERIOD;
+    }
+
+    // the lead-in and 32 bits, 5 pulses a call
+    CHECK(IR_Decoder_DecodeBounded(pDecoder, 5));
+    BYTES_EQUAL(4, pDecoder->pulseNumber);
+    CHECK(pDecoder->state == Address);
+    do
+    {
+        calls++;
+    } while (IR_Decoder_DecodeBounded(pDecoder, 5));
+
+    BYTES_EQUAL(6, calls);
+    BYTES_EQUAL(0x2C, decodedCommand);
+    CHECK(pDecoder->state == LeadIn);
+    BYTES_EQUAL(0, IR_Decoder_DecodeBounded(pDecoder, 5));
+}
+
+TEST(IR_Decoder, ContextCallback)
+{
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x33, times);
+    uint8_t contextCommand = 0;
+
+    // the context callback is used instead of decodeCallback
+    pDecoder->contextCallback = &contextFinished_callback;
+    pDecoder->callbackContext = &contextCommand;
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+
+    BYTES_EQUAL(0x33, contextCommand);
+    BYTES_EQUAL(0, decodedCommand);
+}
+
+TEST(IR_Decoder, TimingSwapBetweenFrames)
+{
+    IR_Timing_t strict;
+    uint64_t times[72];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x16, times);
+    const IR_Timing_t *initial = pDecoder->timing;
+
+    // 550us marks fall outside a short window ending at 545us
+    IR_Timing_Default(&strict);
+    strict.shortHigh = 545;
+    CHECK(IR_Timing_Build(&strict));
+
+    // swapped mid frame, the frame finishes on the profile it started with
+    IR_Decoder_DecodeTimestamps(pDecoder, times, 31);
+    IR_Decoder_SetTiming(pDecoder, &strict);
+    POINTERS_EQUAL(initial, pDecoder->timing);
+    IR_Decoder_DecodeTimestamps(pDecoder, &times[31], count - 31);
+
+    BYTES_EQUAL(0x16, decodedCommand);
+    BYTES_EQUAL(0, pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError);
+    POINTERS_EQUAL(&strict, pDecoder->timing);
+
+    // the next frame is classified by the new one
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, times[0] + 108000 * CLOCK_SPEED_MHZ, 0x00, 0x17, times);
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    BYTES_EQUAL(0xFF, pMessage->commandError);
+
+    // and back to the defaults
+    IR_Decoder_SetTiming(pDecoder, NULL);
+    count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, times[0] + 108000 * CLOCK_SPEED_MHZ, 0x00, 0x18, times);
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+    BYTES_EQUAL(0x18, decodedCommand);
+    BYTES_EQUAL(0, pMessage->commandError);
+    POINTERS_EQUAL(initial, pDecoder->timing);
+}
+
+TEST(IR_Decoder, TimingWidensLeadIn)
+{
+    IR_Timing_t tolerant;
+
+    // an 8600us mark is short of the default lead-in window
+    data[0] = 100000;
+    data[1] = data[0] + 8600 * CLOCK_SPEED_MHZ;
+    data[2] = data[1] + 4500 * CLOCK_SPEED_MHZ;
+    data[3] = data[2] + 560 * CLOCK_SPEED_MHZ;
+    IR_Decoder_Decode(pDecoder);
+    CHECK(pDecoder->state == LeadIn);
+
+    // the ring's tick compares follow the profile too
+    IR_Timing_Default(&tolerant);
+    tolerant.leadInMarkLow = 8500;
+    CHECK(IR_Timing_Build(&tolerant));
+    IR_Decoder_SetTiming(pDecoder, &tolerant);
+    data[4] = 1000000;
+    data[5] = data[4] + 8600 * CLOCK_SPEED_MHZ;
+    data[6] = data[5] + 4500 * CLOCK_SPEED_MHZ;
+    data[7] = data[6] + 560 * CLOCK_SPEED_MHZ;
+    IR_Decoder_Decode(pDecoder);
+    CHECK(pDecoder->state == Address);
+}
+
+TEST(IR_Decoder, DefaultTimingIsBuilt)
+{
+    IR_Timing_t timing;
+    IR_Timing_t built;
+
+    // the compiled in defaults match what IR_Timing_Build makes of their windows
+    IR_Timing_Default(&timing);
+    built = timing;
+    memset(built.lowBound, 0xAA, sizeof(built.lowBound));
+    memset(built.highBound, 0xAA, sizeof(built.highBound));
+    memset(built.classTable, 0xAA, sizeof(built.classTable));
+    CHECK(IR_Timing_Build(&built));
+
+    MEMCMP_EQUAL(&built, &timing, sizeof(timing));
+    MEMCMP_EQUAL(&timing, pDecoder->timing, sizeof(timing));
+}
+
+TEST(IR_Decoder, TimingBuildRejects)
+{
+    IR_Timing_t timing;
+
+    IR_Timing_Default(&timing);
+    CHECK(IR_Timing_Build(&timing));
+
+    // an empty window
+    timing.shortLow = 600;
+    timing.shortHigh = 500;
+    BYTES_EQUAL(0, IR_Timing_Build(&timing));
+
+    // past the table
+    IR_Timing_Default(&timing);
+    timing.leadInMarkHigh = 11000;
+    BYTES_EQUAL(0, IR_Timing_Build(&timing));
+
+    // disjoint but within one 32us bucket of each other
+    IR_Timing_Default(&timing);
+    timing.longLow = 603;
+    BYTES_EQUAL(0, IR_Timing_Build(&timing));
+    timing.longLow = 640;
+    CHECK(IR_Timing_Build(&timing));
+
+    // a timeout within a bit's widths abandons every frame
+    IR_Timing_Default(&timing);
+    timing.edgeTimeout = 0;
+    BYTES_EQUAL(0, IR_Timing_Build(&timing));
+    timing.edgeTimeout = 1000;
+    BYTES_EQUAL(0, IR_Timing_Build(&timing));
+    timing.edgeTimeout = timing.longHigh;
+    BYTES_EQUAL(0, IR_Timing_Build(&timing));
+    timing.edgeTimeout = timing.longHigh + 1;
+    CHECK(IR_Timing_Build(&timing));
+}
+
+#ifdef IR_DECODER_TRACE
+TEST(IR_Decoder, TraceTimes)
+{
+    uint64_t times[72];
+#ifdef IR_DECODER_DURATIONS
+    uint32_t captures[72];
+    uint16_t durations[72];
+#endif
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x17, times);
+
+    // each read of the clock moves it on by 10
+    traceClock = 5000;
+    pDecoder->traceTime = &fakeTraceTime;
+    IR_Decoder_DecodeTimestamps(pDecoder, times, count);
+
+    BYTES_EQUAL(0x17, decodedCommand);
+    LONGLONGS_EQUAL(5000, pMessage->decodeTime);
+    LONGLONGS_EQUAL(5010, pMessage->callbackTime);
+
+#ifdef IR_DECODER_DURATIONS
+    // widths alone have no capture times
+    for (uint16_t i = 0; i < count; i++)
+    {
+        captures[i] = times[i];
+    }
+    pDecoder->traceTime = NULL;
+    IR_Decoder_Init(pDecoder);
+    decodedCommand = 0;
+    IR_Decoder_DecodeDurations(pDecoder, durations, IR_Decoder_ToDurations(pDecoder, captures, count, durations));
+    BYTES_EQUAL(0x17, decodedCommand);
+    LONGLONGS_EQUAL(0, pMessage->firstEdge);
+    LONGLONGS_EQUAL(0, pMessage->decodeTime);
+#endif
+}
+
+static uint64_t fakeTraceTime(void)
+{
+    uint64_t time = traceClock;
+
+    traceClock += 10;
+    return time;
+}
+#endif
+
 static void decodeFinished_callback(IR_Message_t *pMessage)
 {
     if (pMessage)
@@ -788,4 +1586,9 @@ static void decodeFinished_callback(IR_Message_t *pMessage)
             repeatCommand = pMessage->repeat;
         }
     }
-}
\ No newline at end of file
+}
+
+static void contextFinished_callback(void *context, IR_Message_t *pMessage)
+{
+    *(uint8_t *)context = pMessage->command;
+}
@@ -0,0 +1,168 @@
+extern "C"
+{
+#include "IR_Decoder.h"
+#include "IR_Encoder.h"
+
+#include <string.h>
+}
+
+#include "CppUTest/TestHarness.h"
+
+#define BUFFER_SIZE     136
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+
+static uint32_t data[BUFFER_SIZE];
+static IR_Encoder_t encoder;
+static IR_Decoder_t decoder;
+static IR_Message_t message;
+static IR_Message_t decoded;
+static uint8_t callbacks;
+
+static void decodeFinished_callback(IR_Message_t *pMessage);
+
+TEST_GROUP(IR_Encoder)
+{
+    void setup()
+    {
+        callbacks = 0;
+        memset(&decoded, 0, sizeof(decoded));
+        encoder.period = PERIOD;
+        encoder.clockSpeed = CLOCK_SPEED_MHZ;
+        IR_Encoder_Init(&encoder, 1000);
+        IR_Decoder_ConfigDefaults(&decoder);
+        decoder.buffer = data;
+        decoder.bufferSize = BUFFER_SIZE;
+        decoder.clockSpeed = CLOCK_SPEED_MHZ;
+        decoder.period = PERIOD;
+        decoder.message = &message;
+        decoder.decodeCallback = &decodeFinished_callback;
+        IR_Decoder_Init(&decoder);
+    }
+
+    void teardown()
+    {
+        memset(data, 0, sizeof(data));
+    }
+};
+
+TEST(IR_Encoder, Init)
+{
+    IR_Encoder_Init(&encoder, PERIOD + 5);
+    LONGLONGS_EQUAL(5, encoder.time);
+}
+
+TEST(IR_Encoder, FrameTiming)
+{
+    BYTES_EQUAL(IR_ENCODER_FRAME_EDGES, IR_Encoder_Frame(&encoder, 0x00, 0x01, data));
+
+    LONGLONGS_EQUAL(1000, data[0]);
+    LONGLONGS_EQUAL(1000 + 9000 * CLOCK_SPEED_MHZ, data[1]);
+    LONGLONGS_EQUAL(data[1] + 4500 * CLOCK_SPEED_MHZ, data[2]);
+    // command bit 0 is a one, address bit 0 a zero
+    LONGLONGS_EQUAL(data[2] + 550 * CLOCK_SPEED_MHZ, data[3]);
+    LONGLONGS_EQUAL(data[3] + 550 * CLOCK_SPEED_MHZ, data[4]);
+    LONGLONGS_EQUAL(data[34] + 550 * CLOCK_SPEED_MHZ, data[35]);
+    LONGLONGS_EQUAL(data[35] + 1650 * CLOCK_SPEED_MHZ, data[36]);
+    LONGLONGS_EQUAL(data[66] + 550 * CLOCK_SPEED_MHZ, data[67]);
+
+    // the next frame starts 108ms after this one
+    LONGLONGS_EQUAL((1000 + 108000 * CLOCK_SPEED_MHZ) % PERIOD, encoder.time);
+}
+
+TEST(IR_Encoder, RoundTrip)
+{
+    IR_Encoder_Frame(&encoder, 0x5A, 0xC3, data);
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, callbacks);
+    BYTES_EQUAL(0x5A, decoded.address);
+    BYTES_EQUAL(0xA5, decoded.addressInv);
+    BYTES_EQUAL(0xC3, decoded.command);
+    BYTES_EQUAL(0x3C, decoded.commandInv);
+    BYTES_EQUAL(0, decoded.addressError | decoded.addressInvError | decoded.commandError | decoded.commandInvError);
+    BYTES_EQUAL(0, decoded.repeat);
+}
+
+TEST(IR_Encoder, RoundTripMessage)
+{
+    IR_Message_t extended;
+
+    memset(&extended, 0, sizeof(extended));
+    extended.address = 0x12;
+    extended.addressInv = 0x34;
+    extended.command = 0x56;
+    extended.commandInv = 0xA9;
+
+    BYTES_EQUAL(IR_ENCODER_FRAME_EDGES, IR_Encoder_Message(&encoder, &extended, data));
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(0x12, decoded.address);
+    BYTES_EQUAL(0x34, decoded.addressInv);
+    BYTES_EQUAL(0x56, decoded.command);
+    BYTES_EQUAL(0xA9, decoded.commandInv);
+}
+
+TEST(IR_Encoder, RoundTripRepeats)
+{
+    uint8_t index = IR_Encoder_Frame(&encoder, 0x00, 0x16, data);
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        BYTES_EQUAL(IR_ENCODER_REPEAT_EDGES, IR_Encoder_Repeat(&encoder, &data[index]));
+        index += IR_ENCODER_REPEAT_EDGES;
+    }
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(4, callbacks);
+    BYTES_EQUAL(0x16, decoded.command);
+    BYTES_EQUAL(3, decoded.repeat);
+    BYTES_EQUAL(index, decoder.currentIndex);
+}
+
+TEST(IR_Encoder, PeriodWrap)
+{
+    IR_Encoder_Init(&encoder, PERIOD - 20000 * CLOCK_SPEED_MHZ);
+
+    IR_Encoder_Frame(&encoder, 0x81, 0x7E, data);
+
+    CHECK(data[0] > data[IR_ENCODER_FRAME_EDGES - 1]);
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, callbacks);
+    BYTES_EQUAL(0x81, decoded.address);
+    BYTES_EQUAL(0x7E, decoded.command);
+    BYTES_EQUAL(0, decoded.addressError | decoded.addressInvError | decoded.commandError | decoded.commandInvError);
+}
+
+TEST(IR_Encoder, PeriodWrap32Bit)
+{
+    // a free running 32 bit timer, sums of compare times overflow before they wrap at the period
+    encoder.period = UINT32_MAX;
+    decoder.period = UINT32_MAX;
+    IR_Encoder_Init(&encoder, UINT32_MAX - 20000 * CLOCK_SPEED_MHZ);
+
+    IR_Encoder_Frame(&encoder, 0x81, 0x7E, data);
+
+    LONGS_EQUAL(UINT32_MAX - 11000 * CLOCK_SPEED_MHZ, data[1]);
+    CHECK(data[0] > data[IR_ENCODER_FRAME_EDGES - 1]);
+    // the next frame 108ms after this one, past the wrap
+    LONGS_EQUAL(88000 * CLOCK_SPEED_MHZ, encoder.time);
+
+    IR_Decoder_Decode(&decoder);
+
+    BYTES_EQUAL(1, callbacks);
+    BYTES_EQUAL(0x7E, decoded.command);
+    BYTES_EQUAL(0, decoded.addressError | decoded.addressInvError | decoded.commandError | decoded.commandInvError);
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    if (pMessage)
+    {
+        callbacks++;
+        decoded = *pMessage;
+    }
+}
@@ -0,0 +1,361 @@
+#include "IR_Generator.h"
+#include "IR_Encoder.h"
+#include "IR_Timing.h"
+
+#include <string.h>
+
+#define FRAMEBITS 32
+#define GLITCH_MAXPULSE 50
+// long enough that a us clock never wraps within a trace
+#define TRACE_PERIOD 1000000000
+
+static uint16_t writePulses(IR_Generator_t *generator, const uint16_t *pulses, uint8_t count, uint32_t *buffer);
+static uint16_t writeEdge(IR_Generator_t *generator, uint32_t pulseTime, uint32_t *buffer, uint16_t index);
+static uint8_t chance(IR_Generator_t *generator, uint16_t rate);
+
+void IR_Generator_Init(IR_Generator_t *generator, uint32_t start, uint32_t seed)
+{
+    generator->time = start % generator->period;
+    generator->seed = seed ? seed : 1;
+    generator->jitter = 0;
+    generator->glitchRate = 0;
+    generator->dropRate = 0;
+    generator->framePeriod = FRAME_PERIOD;
+}
+
+uint16_t IR_Generator_Frame(IR_Generator_t *generator, uint8_t address, uint8_t command, uint32_t *buffer)
+{
+    uint32_t frame = address | (uint8_t)~address << 8 | (uint32_t)command << 16 | (uint32_t)(uint8_t)~command << 24;
+    uint16_t pulses[2 * FRAMEBITS + 3];
+    uint8_t count = 0;
+
+    pulses[count++] = LEADIN_LOWPULSE;
+    pulses[count++] = LEADIN_HIGHPULSE;
+    for (uint8_t pulseNumber = 0; pulseNumber < FRAMEBITS; pulseNumber++)
+    {
+        pulses[count++] = SHORTPULSE;
+        pulses[count++] = (frame >> pulseNumber) & 1 ? LONGPULSE : SHORTPULSE;
+    }
+    pulses[count++] = SHORTPULSE;
+
+    return writePulses(generator, pulses, count, buffer);
+}
+
+uint16_t IR_Generator_Repeat(IR_Generator_t *generator, uint32_t *buffer)
+{
+    static const uint16_t pulses[] = { LEADIN_LOWPULSE, REPEAT_HIGHPULSE, SHORTPULSE };
+
+    return writePulses(generator, pulses, sizeof(pulses) / sizeof(pulses[0]), buffer);
+}
+
+uint16_t IR_Generator_Noise(IR_Generator_t *generator, uint16_t count, uint16_t maxPulse, uint32_t *buffer)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        buffer[i] = generator->time;
+        generator->time = (generator->time + (1 + IR_Generator_Random(generator) % maxPulse) * generator->clockSpeed) %
+                          generator->period;
+    }
+
+    return count;
+}
+
+uint32_t IR_Generator_Random(IR_Generator_t *generator)
+{
+    uint32_t x = generator->seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    generator->seed = x;
+
+    return x;
+}
+
+uint16_t IR_Generator_Timestamps(uint8_t clockSpeed, uint64_t start, uint8_t address, uint8_t command,
+                                 uint64_t *times)
+{
+    IR_Encoder_t encoder;
+    uint32_t edges[IR_ENCODER_FRAME_EDGES];
+    uint8_t count;
+
+    // encoded from 0 on a clock that cannot wrap within a frame
+    encoder.period = UINT32_MAX;
+    encoder.clockSpeed = clockSpeed;
+    IR_Encoder_Init(&encoder, 0);
+    count = IR_Encoder_Frame(&encoder, address, command, edges);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        times[i] = start + edges[i];
+    }
+
+    return count;
+}
+
+uint16_t IR_Generator_Samples(uint8_t clockSpeed, const uint64_t *times, uint16_t count, uint32_t sampleNs,
+                              uint32_t *samples)
+{
+    uint64_t end = times[count - 1] * 1000 / clockSpeed + 32ULL * sampleNs;
+    uint16_t words = (end / sampleNs + 31) / 32;
+    uint16_t edge = 0;
+
+    for (uint32_t sample = 0; sample < words * 32U; sample++)
+    {
+        while (edge < count && times[edge] * 1000 / clockSpeed <= (uint64_t)sample * sampleNs)
+        {
+            edge++;
+        }
+
+        if (sample % 32 == 0)
+        {
+            samples[sample / 32] = 0;
+        }
+        samples[sample / 32] |= (uint32_t)!(edge & 1) << (sample % 32);
+    }
+
+    return words;
+}
+
+uint16_t IR_Generator_Carrier(uint8_t clockSpeed, const uint64_t *times, uint16_t count, uint64_t *carrier)
+{
+    uint32_t cycle = clockSpeed * 1000000 / IR_GENERATOR_CARRIER_HZ;
+    uint16_t edges = 0;
+
+    // each mark runs from times[2k] to times[2k + 1]
+    for (uint16_t mark = 0; mark + 1 < count; mark += 2)
+    {
+        uint64_t time = times[mark];
+
+        do
+        {
+            carrier[edges++] = time;
+            carrier[edges++] = time + cycle / 3;
+            time += cycle;
+        } while (time + cycle <= times[mark + 1]);
+    }
+
+    return edges;
+}
+
+void IR_Generator_Widths(const uint32_t *edges, uint8_t count, uint32_t period, uint32_t gap,
+                         void (*writeEdge)(uint32_t us))
+{
+    writeEdge(gap);
+    for (uint8_t i = 1; i < count; i++)
+    {
+        writeEdge((edges[i] + period - edges[i - 1]) % period);
+    }
+}
+
+void IR_Generator_DmaInit(IR_GeneratorDma_t *dma, uint32_t start)
+{
+    dma->index = 0;
+    dma->risingIndex = 0;
+    dma->nextRising = 0;
+    dma->wrapIrq = 1;
+    dma->halfTransfers = 0;
+    dma->fullTransfers = 0;
+    dma->time = start;
+    dma->clock = start;
+    memset(dma->data, 0, dma->size * sizeof(*dma->data));
+    if (dma->risingData)
+    {
+        memset(dma->risingData, 0, dma->size * sizeof(*dma->risingData));
+    }
+}
+
+void IR_Generator_DmaAdvance(IR_GeneratorDma_t *dma, uint32_t us)
+{
+    dma->time = (dma->time + us * dma->clockSpeed) % dma->period;
+    dma->clock += (uint64_t)us * dma->clockSpeed;
+}
+
+void IR_Generator_DmaWrite(IR_GeneratorDma_t *dma, uint32_t us)
+{
+    IR_Generator_DmaAdvance(dma, us);
+    dma->data[dma->index] = dma->time;
+    if (dma->durations)
+    {
+        dma->durations[dma->index] = us > UINT16_MAX ? UINT16_MAX : us;
+    }
+    dma->index = (dma->index + 1) % dma->size;
+
+    if (dma->index == dma->size / 2)
+    {
+        dma->halfTransfers++;
+    }
+    else if (dma->index == 0)
+    {
+        dma->fullTransfers++;
+        if (dma->wrapIrq)
+        {
+            IR_Decoder_CaptureWrapped(dma->decoder);
+        }
+    }
+}
+
+uint32_t IR_Generator_DmaRemaining(const IR_GeneratorDma_t *dma)
+{
+    return dma->size - dma->index;
+}
+
+#ifdef IR_DECODER_DUAL_RING
+void IR_Generator_DmaDualWrite(IR_GeneratorDma_t *dma, uint32_t us)
+{
+    // edges alternate, a frame starts with a falling one
+    if (!dma->nextRising)
+    {
+        IR_Generator_DmaWrite(dma, us);
+        dma->nextRising = 1;
+        return;
+    }
+
+    IR_Generator_DmaAdvance(dma, us);
+    dma->risingData[dma->risingIndex] = dma->time;
+    dma->risingIndex = (dma->risingIndex + 1) % dma->size;
+    if (!dma->risingIndex)
+    {
+        IR_Decoder_RisingWrapped(dma->decoder);
+    }
+    dma->nextRising = 0;
+}
+
+uint32_t IR_Generator_DmaRisingRemaining(const IR_GeneratorDma_t *dma)
+{
+    return dma->size - dma->risingIndex;
+}
+#endif
+
+void IR_Generator_Keypress(IR_GeneratorTrace_t *trace, uint32_t ms, uint8_t command, uint8_t repeats)
+{
+    IR_Encoder_t encoder;
+    uint32_t edges[IR_ENCODER_FRAME_EDGES];
+    uint8_t count;
+
+    // encoded on a us clock
+    encoder.period = TRACE_PERIOD;
+    encoder.clockSpeed = 1;
+    IR_Encoder_Init(&encoder, ms * 1000);
+    count = IR_Encoder_Frame(&encoder, 0x00, command, edges);
+    for (uint8_t i = 0; i <= repeats; i++)
+    {
+        memcpy(&trace->edges[trace->length], edges, count * sizeof(uint32_t));
+        trace->length += count;
+        count = IR_Encoder_Repeat(&encoder, edges);
+    }
+}
+
+uint16_t IR_Generator_Simulate(IR_GeneratorTrace_t *trace, IR_GeneratorDma_t *dma, uint8_t sleepWhenIdle)
+{
+    uint16_t decodes = 0;
+    uint16_t next = 0;
+    uint32_t lastEdge = 0;
+    uint32_t wakeTime = 0;
+    uint8_t asleep = 0;
+
+    trace->activeNs = 0;
+    for (uint32_t ms = 1; ms <= trace->ms; ms++)
+    {
+        uint8_t edge = 0;
+
+        while (next < trace->length && trace->edges[next] <= ms * 1000)
+        {
+            IR_Generator_DmaWrite(dma, trace->edges[next] - lastEdge);
+            lastEdge = trace->edges[next++];
+            edge = 1;
+        }
+
+        if (asleep)
+        {
+            // the wake-on-edge interrupt restarts the decode timer
+            if (edge)
+            {
+                asleep = 0;
+                wakeTime = ms;
+            }
+        }
+        else if ((ms - wakeTime) % trace->pollMs == 0)
+        {
+            uint64_t start = trace->now ? trace->now() : 0;
+
+            if (sleepWhenIdle && wakeTime == ms - trace->pollMs)
+            {
+                IR_Decoder_Resume(dma->decoder);
+            }
+            else
+            {
+                IR_Decoder_Decode(dma->decoder);
+            }
+            decodes++;
+            trace->activeNs += trace->now ? trace->now() - start : 0;
+
+            asleep = sleepWhenIdle && IR_Decoder_IsIdle(dma->decoder, trace->pollMs, trace->idleMs);
+        }
+    }
+
+    return decodes;
+}
+
+static uint16_t writePulses(IR_Generator_t *generator, const uint16_t *pulses, uint8_t count, uint32_t *buffer)
+{
+    uint32_t start = generator->time;
+    uint32_t elapsed = 0;
+    uint16_t index = 0;
+
+    index = writeEdge(generator, 0, buffer, index);
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        int32_t pulseTime = pulses[i];
+
+        if (generator->jitter)
+        {
+            pulseTime += (int32_t)(IR_Generator_Random(generator) % (2 * generator->jitter + 1)) - generator->jitter;
+        }
+
+        if (pulseTime < 1)
+        {
+            pulseTime = 1;
+        }
+
+        // split the pulse around a short spike of the opposite level
+        if (chance(generator, generator->glitchRate))
+        {
+            int32_t glitch = 1 + IR_Generator_Random(generator) % GLITCH_MAXPULSE;
+            int32_t before = IR_Generator_Random(generator) % pulseTime;
+
+            index = writeEdge(generator, before, buffer, index);
+            index = writeEdge(generator, glitch, buffer, index);
+            elapsed += before + glitch;
+            pulseTime = pulseTime > before + glitch ? pulseTime - before - glitch : 1;
+        }
+
+        index = writeEdge(generator, pulseTime, buffer, index);
+        elapsed += pulseTime;
+    }
+
+    // the next frame or repeat starts framePeriod after this one
+    if (generator->framePeriod > elapsed)
+    {
+        generator->time = (start + generator->framePeriod * generator->clockSpeed) % generator->period;
+    }
+
+    return index;
+}
+
+static uint16_t writeEdge(IR_Generator_t *generator, uint32_t pulseTime, uint32_t *buffer, uint16_t index)
+{
+    generator->time = (generator->time + pulseTime * generator->clockSpeed) % generator->period;
+
+    if (!chance(generator, generator->dropRate))
+    {
+        buffer[index++] = generator->time;
+    }
+
+    return index;
+}
+
+static uint8_t chance(IR_Generator_t *generator, uint16_t rate)
+{
+    return rate && (IR_Generator_Random(generator) & 0xFFFF) < rate;
+}
@@ -0,0 +1,95 @@
+#ifndef IR_GENERATOR_H
+#define IR_GENERATOR_H
+
+#include <stdint.h>
+
+#include "IR_Decoder.h"
+
+// most edges a single frame can produce when every one of its 67 pulses is glitched
+#define IR_GENERATOR_MAX_EDGES (1 + 3 * 67)
+// 38kHz carrier on for a third of each cycle
+#define IR_GENERATOR_CARRIER_HZ 38000
+
+typedef struct IR_Generator_s {
+    uint32_t period;
+    uint8_t clockSpeed; // MHz
+    uint32_t time; // timer value of the next edge
+    uint32_t seed; // xorshift state, must not be 0
+    uint16_t jitter; // us, every pulse is moved by up to +/- jitter
+    uint16_t glitchRate; // per 65536 pulses, a short spike is inserted in the pulse
+    uint16_t dropRate; // per 65536 edges, the edge is not captured
+    uint32_t framePeriod; // us from the start of one frame or repeat to the next
+} IR_Generator_t;
+
+void IR_Generator_Init(IR_Generator_t *generator, uint32_t start, uint32_t seed);
+// write the capture timestamps of a frame, returns the number of edges written
+uint16_t IR_Generator_Frame(IR_Generator_t *generator, uint8_t address, uint8_t command, uint32_t *buffer);
+uint16_t IR_Generator_Repeat(IR_Generator_t *generator, uint32_t *buffer);
+// count edges of random width between 1us and maxPulse us
+uint16_t IR_Generator_Noise(IR_Generator_t *generator, uint16_t count, uint16_t maxPulse, uint32_t *buffer);
+uint32_t IR_Generator_Random(IR_Generator_t *generator);
+// the edges of an encoded frame on a 64 bit clock of clockSpeed ticks per us from start, returns their count
+uint16_t IR_Generator_Timestamps(uint8_t clockSpeed, uint64_t start, uint8_t address, uint8_t command,
+                                 uint64_t *times);
+
+// fake circular DMA channel capturing a timer into data, with the widths a timer reset on every edge would
+// capture in durations; IR_Generator_DmaDualWrite puts every second edge on a rising channel instead
+typedef struct IR_GeneratorDma_s {
+    IR_Decoder_t *decoder; // told of each wrap while wrapIrq is set
+    uint32_t *data;
+    uint16_t *durations; // may be NULL
+    uint32_t *risingData; // may be NULL without IR_Generator_DmaDualWrite
+    uint8_t size; // of each ring
+    uint32_t period;
+    uint8_t clockSpeed; // MHz
+    uint8_t index;
+    uint8_t risingIndex;
+    uint8_t nextRising; // the next dual write is a rising edge
+    uint8_t wrapIrq;
+    uint8_t halfTransfers;
+    uint8_t fullTransfers;
+    uint32_t time; // timer value of the last edge
+    uint64_t clock; // time counting on past the period
+} IR_GeneratorDma_t;
+
+// a usage trace of edge times in us since the start, polled every pollMs for ms and, when asked to, asleep
+// from IR_Decoder_IsIdle until the next edge
+typedef struct IR_GeneratorTrace_s {
+    uint32_t *edges;
+    uint16_t length;
+    uint32_t ms;
+    uint16_t pollMs;
+    uint16_t idleMs;
+    uint64_t (*now)(void); // ns, times the decode calls into activeNs, may be NULL
+    uint64_t activeNs;
+} IR_GeneratorTrace_t;
+
+// the pin level every sampleNs from time 0 of times, high until the first edge and toggled by each one,
+// with a word of idle after the last, returns the words written
+uint16_t IR_Generator_Samples(uint8_t clockSpeed, const uint64_t *times, uint16_t count, uint32_t sampleNs,
+                              uint32_t *samples);
+// each mark of times as whole carrier cycles starting on and ending off, returns the edges written
+uint16_t IR_Generator_Carrier(uint8_t clockSpeed, const uint64_t *times, uint16_t count, uint64_t *carrier);
+// write gap then the width up to each later edge of an encoded frame or repeat
+void IR_Generator_Widths(const uint32_t *edges, uint8_t count, uint32_t period, uint32_t gap,
+                         void (*writeEdge)(uint32_t us));
+
+// set decoder, the rings, size, period and clockSpeed first, empties the rings and starts the timer at start
+void IR_Generator_DmaInit(IR_GeneratorDma_t *dma, uint32_t start);
+// the timer runs on by us without a capture
+void IR_Generator_DmaAdvance(IR_GeneratorDma_t *dma, uint32_t us);
+void IR_Generator_DmaWrite(IR_GeneratorDma_t *dma, uint32_t us);
+// the DMA counter, for captureRemaining
+uint32_t IR_Generator_DmaRemaining(const IR_GeneratorDma_t *dma);
+#ifdef IR_DECODER_DUAL_RING
+void IR_Generator_DmaDualWrite(IR_GeneratorDma_t *dma, uint32_t us);
+// the same for risingRemaining
+uint32_t IR_Generator_DmaRisingRemaining(const IR_GeneratorDma_t *dma);
+#endif
+
+// add a keypress at ms with its repeats a code period apart
+void IR_Generator_Keypress(IR_GeneratorTrace_t *trace, uint32_t ms, uint8_t command, uint8_t repeats);
+// feed the trace to dma and its decoder, returns the decode calls
+uint16_t IR_Generator_Simulate(IR_GeneratorTrace_t *trace, IR_GeneratorDma_t *dma, uint8_t sleepWhenIdle);
+
+#endif
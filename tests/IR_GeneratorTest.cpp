@@ -0,0 +1,229 @@
+extern "C"
+{
+#include "IR_Decoder.h"
+#include "IR_Generator.h"
+
+#include <string.h>
+}
+
+#include "CppUTest/TestHarness.h"
+
+#define BUFFER_SIZE     136
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+
+// edges written to the ring between decode calls
+#define DECODE_CHUNK    32
+
+static uint32_t data[BUFFER_SIZE];
+static uint8_t dmaIndex;
+static uint32_t edges[IR_GENERATOR_MAX_EDGES];
+
+static IR_Generator_t generator;
+static IR_Decoder_t decoder;
+static IR_Message_t message;
+static uint32_t frames;
+static uint32_t cleanFrames;
+static uint32_t repeats;
+static uint32_t lastFrame;
+
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint32_t fakeDmaRemaining(void);
+static void stream(const uint32_t *times, uint16_t count);
+static uint32_t sendFrames(uint32_t count, uint8_t withRepeats, uint32_t *mismatches);
+
+TEST_GROUP(IR_Generator)
+{
+    void setup()
+    {
+        frames = 0;
+        cleanFrames = 0;
+        repeats = 0;
+        lastFrame = 0;
+        dmaIndex = 0;
+        generator.period = PERIOD;
+        generator.clockSpeed = CLOCK_SPEED_MHZ;
+        IR_Generator_Init(&generator, 1000, 0x1234567);
+        IR_Decoder_ConfigDefaults(&decoder);
+        decoder.buffer = data;
+        decoder.bufferSize = BUFFER_SIZE;
+        decoder.clockSpeed = CLOCK_SPEED_MHZ;
+        decoder.period = PERIOD;
+        decoder.message = &message;
+        decoder.decodeCallback = &decodeFinished_callback;
+        decoder.captureRemaining = &fakeDmaRemaining;
+        IR_Decoder_Init(&decoder);
+    }
+
+    void teardown()
+    {
+        memset(data, 0, sizeof(data));
+    }
+};
+
+TEST(IR_Generator, FrameEdges)
+{
+    BYTES_EQUAL(68, IR_Generator_Frame(&generator, 0x00, 0x16, edges));
+    LONGLONGS_EQUAL(1000, edges[0]);
+    LONGLONGS_EQUAL(1000 + 9000 * CLOCK_SPEED_MHZ, edges[1]);
+    LONGLONGS_EQUAL((1000 + 108000 * CLOCK_SPEED_MHZ) % PERIOD, generator.time);
+
+    BYTES_EQUAL(4, IR_Generator_Repeat(&generator, edges));
+    LONGLONGS_EQUAL(edges[1] + 2500 * CLOCK_SPEED_MHZ, edges[2]);
+}
+
+TEST(IR_Generator, Timestamps)
+{
+    uint64_t times[68];
+
+    // far past the period, a 64 bit clock does not wrap
+    BYTES_EQUAL(68, IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 3ULL * PERIOD, 0x00, 0x16, times));
+    LONGLONGS_EQUAL(3ULL * PERIOD, times[0]);
+    LONGLONGS_EQUAL(3ULL * PERIOD + 9000 * CLOCK_SPEED_MHZ, times[1]);
+    LONGLONGS_EQUAL(3ULL * PERIOD + 13500 * CLOCK_SPEED_MHZ, times[2]);
+}
+
+TEST(IR_Generator, DroppedEdges)
+{
+    generator.dropRate = 0xFFFF;
+
+    CHECK(IR_Generator_Frame(&generator, 0x00, 0x16, edges) < 4);
+}
+
+TEST(IR_Generator, CleanFrames)
+{
+    uint32_t mismatches;
+
+    LONGS_EQUAL(1000, sendFrames(1000, 1, &mismatches));
+    LONGS_EQUAL(1000, cleanFrames);
+    LONGS_EQUAL(1000, repeats);
+    LONGS_EQUAL(0, mismatches);
+    LONGS_EQUAL(0, decoder.overruns);
+}
+
+TEST(IR_Generator, JitterInsideWindows)
+{
+    uint32_t mismatches;
+
+    // the narrowest window, the 100us short pulse, tolerates 49us
+    generator.jitter = 45;
+
+    LONGS_EQUAL(1000, sendFrames(1000, 0, &mismatches));
+    LONGS_EQUAL(1000, cleanFrames);
+    LONGS_EQUAL(0, mismatches);
+}
+
+TEST(IR_Generator, JitterOutsideWindows)
+{
+    uint32_t mismatches;
+
+    generator.jitter = 300;
+
+    sendFrames(1000, 0, &mismatches);
+
+    CHECK(cleanFrames < 100);
+    LONGS_EQUAL(0, mismatches);
+}
+
+TEST(IR_Generator, GlitchesAndDrops)
+{
+    uint32_t mismatches;
+    uint32_t sent = 20000;
+
+    generator.jitter = 30;
+    generator.glitchRate = 200;
+    generator.dropRate = 100;
+
+    sendFrames(sent, 1, &mismatches);
+
+    // damaged frames are dropped or flagged, never decoded as a different frame
+    // the lead-in search steps one edge at a time so a dropped edge only costs its own frame
+    CHECK(cleanFrames > sent * 2 / 3);
+    CHECK(cleanFrames < sent);
+    LONGS_EQUAL(0, mismatches);
+    CHECK(decoder.currentIndex < BUFFER_SIZE);
+    CHECK(decoder.pulseNumber < 32);
+}
+
+TEST(IR_Generator, NoiseOnly)
+{
+    for (uint16_t i = 0; i < 1000; i++)
+    {
+        stream(edges, IR_Generator_Noise(&generator, IR_GENERATOR_MAX_EDGES, 10000, edges));
+    }
+
+    LONGS_EQUAL(0, cleanFrames);
+    LONGS_EQUAL(0, frames);
+    LONGS_EQUAL(0, decoder.overruns);
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    if (pMessage->repeat)
+    {
+        repeats++;
+        return;
+    }
+
+    frames++;
+    lastFrame = pMessage->address | pMessage->addressInv << 8 |
+                (uint32_t)pMessage->command << 16 | (uint32_t)pMessage->commandInv << 24;
+
+    if (!(pMessage->addressError | pMessage->addressInvError | pMessage->commandError | pMessage->commandInvError))
+    {
+        cleanFrames++;
+    }
+}
+
+static uint32_t fakeDmaRemaining(void)
+{
+    return BUFFER_SIZE - dmaIndex;
+}
+
+static void stream(const uint32_t *times, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        data[dmaIndex] = times[i];
+        dmaIndex = (dmaIndex + 1) % BUFFER_SIZE;
+        if (!dmaIndex)
+        {
+            IR_Decoder_CaptureWrapped(&decoder);
+        }
+
+        if (i % DECODE_CHUNK == DECODE_CHUNK - 1)
+        {
+            IR_Decoder_Decode(&decoder);
+        }
+    }
+
+    IR_Decoder_Decode(&decoder);
+}
+
+static uint32_t sendFrames(uint32_t count, uint8_t withRepeats, uint32_t *mismatches)
+{
+    *mismatches = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t random = IR_Generator_Random(&generator);
+        uint8_t address = random;
+        uint8_t command = random >> 8;
+        uint32_t clean = cleanFrames;
+
+        stream(edges, IR_Generator_Frame(&generator, address, command, edges));
+        if (withRepeats)
+        {
+            stream(edges, IR_Generator_Repeat(&generator, edges));
+        }
+
+        // a frame that passed every bit check must be the one sent
+        if (cleanFrames != clean &&
+            lastFrame != (address | (uint8_t)~address << 8 | (uint32_t)command << 16 | (uint32_t)(uint8_t)~command << 24))
+        {
+            (*mismatches)++;
+        }
+    }
+
+    return frames;
+}
@@ -0,0 +1,332 @@
+extern "C"
+{
+#include "IR_Decoder.h"
+#include "IR_Generator.h"
+#include "IR_Recorder.h"
+
+#include <string.h>
+}
+
+#include "CppUTest/TestHarness.h"
+
+// recording needs the decoder built with it
+#ifdef IR_DECODER_RECORDER
+
+#define BUFFER_SIZE     136
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+#define TRACE_SIZE      65536
+#define MAX_EVENTS      512
+
+typedef struct {
+    uint16_t call;
+    uint8_t address;
+    uint8_t command;
+    uint8_t repeat;
+    uint8_t errors;
+} Event_t;
+
+static uint32_t data[BUFFER_SIZE];
+static uint32_t replayData[BUFFER_SIZE];
+static uint8_t dmaIndex;
+static uint32_t edges[IR_GENERATOR_MAX_EDGES];
+static uint8_t trace[TRACE_SIZE];
+
+static IR_Generator_t generator;
+static IR_Recorder_t recorder;
+static IR_Decoder_t decoder;
+static IR_Decoder_t replayDecoder;
+static IR_Message_t message;
+static IR_Message_t replayMessage;
+static uint32_t clockTime;
+
+// callbacks of the live and the replayed decoder, tagged with the decode call number
+static Event_t liveEvents[MAX_EVENTS];
+static Event_t replayEvents[MAX_EVENTS];
+static Event_t *events;
+static uint16_t eventCount;
+static uint16_t liveCount;
+static uint16_t call;
+
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint32_t fakeDmaRemaining(void);
+static uint32_t fakeClock(void);
+static void write(const uint32_t *times, uint16_t count);
+static void decode(void);
+static uint16_t replay(const uint8_t *input, uint32_t length);
+static void checkReplay(void);
+
+TEST_GROUP(IR_Recorder)
+{
+    void setup()
+    {
+        dmaIndex = 0;
+        clockTime = 0;
+        call = 0;
+        eventCount = 0;
+        events = liveEvents;
+        generator.period = PERIOD;
+        generator.clockSpeed = CLOCK_SPEED_MHZ;
+        IR_Generator_Init(&generator, 1000, 0xC0FFEE);
+        IR_Recorder_Init(&recorder, trace, sizeof(trace));
+        recorder.getTime = &fakeClock;
+        IR_Decoder_ConfigDefaults(&decoder);
+        decoder.buffer = data;
+        decoder.bufferSize = BUFFER_SIZE;
+        decoder.clockSpeed = CLOCK_SPEED_MHZ;
+        decoder.period = PERIOD;
+        decoder.message = &message;
+        decoder.decodeCallback = &decodeFinished_callback;
+        decoder.captureRemaining = &fakeDmaRemaining;
+        decoder.recorder = &recorder;
+        IR_Decoder_Init(&decoder);
+        replayDecoder.buffer = replayData;
+        replayDecoder.message = &replayMessage;
+        replayDecoder.decodeCallback = &decodeFinished_callback;
+    }
+
+    void teardown()
+    {
+        memset(data, 0, sizeof(data));
+        memset(replayData, 0, sizeof(replayData));
+    }
+};
+
+TEST(IR_Recorder, Header)
+{
+    LONGS_EQUAL(IR_RECORDER_HEADER_SIZE, recorder.length);
+    MEMCMP_EQUAL("IRT", trace, 3);
+    BYTES_EQUAL(IR_RECORDER_VERSION, trace[3]);
+    BYTES_EQUAL(IR_RECORDER_FLAG_DMA, trace[4]);
+    BYTES_EQUAL(BUFFER_SIZE, trace[5]);
+    BYTES_EQUAL(CLOCK_SPEED_MHZ, trace[6]);
+    LONGLONGS_EQUAL(PERIOD, trace[8] | trace[9] << 8 | trace[10] << 16 | trace[11] << 24);
+}
+
+TEST(IR_Recorder, CallRecord)
+{
+    uint32_t times[] = { 1000, 1100, 900 };
+    IR_Replay_t replayer;
+    uint32_t callTime;
+
+    clockTime = 77;
+    write(times, 3);
+    decode();
+
+    // call time, no skipped edges, 3 edges as zigzag deltas
+    LONGS_EQUAL(IR_RECORDER_HEADER_SIZE + 9, recorder.length);
+    BYTES_EQUAL(77, trace[12]);
+    BYTES_EQUAL(0, trace[13]);
+    BYTES_EQUAL(3, trace[14]);
+
+    CHECK(IR_Replay_Init(&replayer, trace, recorder.length, &replayDecoder));
+    CHECK(IR_Replay_Next(&replayer, &callTime));
+    LONGS_EQUAL(77, callTime);
+    LONGLONGS_EQUAL(1000, replayData[0]);
+    LONGLONGS_EQUAL(1100, replayData[1]);
+    LONGLONGS_EQUAL(900, replayData[2]);
+    CHECK_FALSE(IR_Replay_Next(&replayer, &callTime));
+}
+
+TEST(IR_Recorder, BadHeader)
+{
+    IR_Replay_t replayer;
+
+    trace[0] = 'X';
+    CHECK_FALSE(IR_Replay_Init(&replayer, trace, recorder.length, &replayDecoder));
+    CHECK_FALSE(IR_Replay_Init(&replayer, trace, 4, &replayDecoder));
+}
+
+TEST(IR_Recorder, ZeroClockOrPeriod)
+{
+    IR_Replay_t replayer;
+    uint8_t clockSpeed = trace[6];
+
+    // either would divide by zero on the first width
+    trace[6] = 0;
+    CHECK_FALSE(IR_Replay_Init(&replayer, trace, recorder.length, &replayDecoder));
+    trace[6] = clockSpeed;
+    memset(&trace[8], 0, 4);
+    CHECK_FALSE(IR_Replay_Init(&replayer, trace, recorder.length, &replayDecoder));
+}
+
+TEST(IR_Recorder, ReplayDma)
+{
+    generator.jitter = 60;
+    generator.glitchRate = 300;
+    generator.dropRate = 200;
+
+    for (uint16_t i = 0; i < 200; i++)
+    {
+        uint32_t random = IR_Generator_Random(&generator);
+        uint16_t count = random & 1 ? IR_Generator_Frame(&generator, random >> 8, random >> 16, edges) :
+                                      IR_Generator_Repeat(&generator, edges);
+
+        // uneven call boundaries, some with nothing new
+        for (uint16_t written = 0; written < count;)
+        {
+            uint16_t chunk = 1 + IR_Generator_Random(&generator) % 40;
+
+            chunk = chunk < count - written ? chunk : count - written;
+            write(&edges[written], chunk);
+            written += chunk;
+            decode();
+            if (chunk & 1)
+            {
+                decode();
+            }
+        }
+    }
+
+    CHECK(eventCount > 50);
+    checkReplay();
+}
+
+TEST(IR_Recorder, ReplayOverrun)
+{
+    for (uint16_t i = 0; i < 30; i++)
+    {
+        uint16_t count = IR_Generator_Frame(&generator, i, 0x80 + i, edges);
+
+        write(edges, count);
+        // every third call comes too late and the ring laps the decoder
+        if (i % 3 != 1)
+        {
+            decode();
+        }
+    }
+
+    CHECK(decoder.overruns > 0);
+    checkReplay();
+    LONGS_EQUAL(decoder.overruns, replayDecoder.overruns);
+}
+
+TEST(IR_Recorder, ReplaySentinel)
+{
+    decoder.captureRemaining = NULL;
+    IR_Decoder_Init(&decoder);
+    BYTES_EQUAL(0, trace[4]);
+
+    for (uint16_t i = 0; i < 50; i++)
+    {
+        uint16_t count = IR_Generator_Frame(&generator, i, ~i, edges);
+
+        // hold back the trailing edge of every other frame to the next call
+        write(edges, count - (i & 1));
+        decode();
+        write(&edges[count - (i & 1)], i & 1);
+        count = IR_Generator_Repeat(&generator, edges);
+        write(edges, count);
+        decode();
+    }
+
+    LONGS_EQUAL(100, eventCount);
+    checkReplay();
+}
+
+TEST(IR_Recorder, TraceFull)
+{
+    uint16_t calls;
+
+    IR_Recorder_Init(&recorder, trace, 400);
+    IR_Decoder_Init(&decoder);
+
+    for (uint16_t i = 0; i < 10; i++)
+    {
+        write(edges, IR_Generator_Frame(&generator, i, i, edges));
+        decode();
+    }
+
+    CHECK(recorder.full);
+    CHECK(recorder.length <= 400);
+
+    // the truncated trace still replays the calls it holds
+    calls = replay(trace, recorder.length);
+    CHECK(calls > 0);
+    CHECK(calls < 10);
+    LONGS_EQUAL(calls, eventCount);
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    if (eventCount < MAX_EVENTS)
+    {
+        Event_t *event = &events[eventCount++];
+
+        event->call = call;
+        event->address = pMessage->address;
+        event->command = pMessage->command;
+        event->repeat = pMessage->repeat;
+        event->errors = pMessage->addressError | pMessage->addressInvError |
+                        pMessage->commandError | pMessage->commandInvError;
+    }
+}
+
+static uint32_t fakeDmaRemaining(void)
+{
+    return BUFFER_SIZE - dmaIndex;
+}
+
+static uint32_t fakeClock(void)
+{
+    return clockTime;
+}
+
+static void write(const uint32_t *times, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        data[dmaIndex] = times[i];
+        dmaIndex = (dmaIndex + 1) % BUFFER_SIZE;
+        if (!dmaIndex)
+        {
+            IR_Decoder_CaptureWrapped(&decoder);
+        }
+    }
+}
+
+static void decode(void)
+{
+    IR_Decoder_Decode(&decoder);
+    call++;
+    clockTime += 1000 + call;
+}
+
+static uint16_t replay(const uint8_t *input, uint32_t length)
+{
+    IR_Replay_t replayer;
+    uint32_t callTime;
+    uint32_t expectedTime = 0;
+
+    liveCount = eventCount;
+    eventCount = 0;
+    call = 0;
+    events = replayEvents;
+
+    CHECK(IR_Replay_Init(&replayer, input, length, &replayDecoder));
+    while (IR_Replay_Next(&replayer, &callTime))
+    {
+        LONGS_EQUAL(expectedTime, callTime);
+        IR_Decoder_Decode(&replayDecoder);
+        call++;
+        expectedTime += 1000 + call;
+    }
+
+    return call;
+}
+
+static void checkReplay(void)
+{
+    uint16_t calls = call;
+
+    CHECK_FALSE(recorder.full);
+    LONGS_EQUAL(calls, replay(trace, recorder.length));
+    LONGS_EQUAL(liveCount, eventCount);
+    MEMCMP_EQUAL(liveEvents, replayEvents, eventCount * sizeof(Event_t));
+    BYTES_EQUAL(decoder.currentIndex, replayDecoder.currentIndex);
+    BYTES_EQUAL(decoder.state, replayDecoder.state);
+    BYTES_EQUAL(decoder.pulseNumber, replayDecoder.pulseNumber);
+    LONGLONGS_EQUAL(decoder.frame, replayDecoder.frame);
+}
+
+#endif
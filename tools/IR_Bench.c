@@ -0,0 +1,371 @@
+// host benchmarks of the decoder, kept out of the unit tests so no test result depends on timing; the
+// figures are host nanoseconds, only the ratios between the runs say anything about a target
+#include "IR_Combiner.h"
+#include "IR_Decoder.h"
+#include "IR_Encoder.h"
+#include "IR_Generator.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BUFFER_SIZE     136
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+
+#define POLL_MS         100
+#define IDLE_MS         300
+#define TRACE_EDGES     1024
+#define TRACE_MS        30000
+#define BENCH_FRAMES    2000
+#define FRAME_GAP       40000
+// edges written to the ring between decode calls
+#define SAMPLE_NS       20000
+#define SAMPLE_WORDS    8000
+#define CARRIER_EDGES   2400
+#define COMBINER_WINDOW 2000
+#define COMBINER_FRAMES 10000
+
+// fake circular DMA channel feeding the capture ring, the duration ring and the rising ring
+static uint32_t data[BUFFER_SIZE];
+static uint16_t durations[BUFFER_SIZE];
+static uint32_t risingData[BUFFER_SIZE];
+static IR_GeneratorDma_t dma;
+static void (*writeEdge)(uint32_t us);
+
+static IR_Encoder_t encoder;
+static IR_Decoder_t decoder;
+static IR_Message_t message;
+static uint32_t frames;
+
+static uint32_t combinerTime;
+static uint8_t combinedCount;
+static uint8_t combinedClean;
+
+// edge times of a simulated usage trace in us since the start
+static uint32_t trace[TRACE_EDGES];
+
+static void benchIdle(void);
+static void benchDurationRing(void);
+static void benchDualRing(void);
+static void benchSamples(void);
+static void benchCarrier(void);
+static void benchCombiner(void);
+static void fakeDmaReset(void);
+static void fakeDmaWrite(uint32_t us);
+static void fakeDmaFrame(uint8_t command);
+static uint32_t fakeDmaRemaining(void);
+static uint32_t fakeRisingRemaining(void);
+static void fakeDualWrite(uint32_t us);
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static void combined_callback(IR_Message_t *pMessage);
+static uint32_t combinerClock(void);
+static uint64_t now(void);
+
+int main(void)
+{
+    benchIdle();
+    benchDurationRing();
+    benchDualRing();
+    benchSamples();
+    benchCarrier();
+    benchCombiner();
+
+    return 0;
+}
+
+// a few keypresses over 30s polled every POLL_MS, against sleeping once IR_Decoder_IsIdle allows
+static void benchIdle(void)
+{
+    IR_GeneratorTrace_t keypresses = {trace, 0, TRACE_MS, POLL_MS, IDLE_MS, &now, 0};
+    uint64_t polledNs;
+    uint16_t polled;
+    uint16_t idle;
+    uint32_t polledFrames;
+
+    IR_Generator_Keypress(&keypresses, 1000, 0x10, 2);
+    IR_Generator_Keypress(&keypresses, 5000, 0x11, 0);
+    IR_Generator_Keypress(&keypresses, 5400, 0x12, 1);
+    IR_Generator_Keypress(&keypresses, 12000, 0x13, 8);
+    IR_Generator_Keypress(&keypresses, 25000, 0x14, 0);
+
+    fakeDmaReset();
+    polled = IR_Generator_Simulate(&keypresses, &dma, 0);
+    polledNs = keypresses.activeNs;
+    polledFrames = frames;
+    fakeDmaReset();
+    idle = IR_Generator_Simulate(&keypresses, &dma, 1);
+
+    // decode time only, each decode also pays the wake from stop mode on target
+    printf("idle: frames polled %u idle %u, decodes polled %u idle %u, cpu active %.1fus vs %.1fus\n",
+           polledFrames, frames, polled, idle, polledNs / 1e3, keypresses.activeNs / 1e3);
+}
+
+// the same frames through the timestamp and the duration ring, a decode per frame
+static void benchDurationRing(void)
+{
+    uint64_t ns[2] = {0, 0};
+    uint32_t decoded[2];
+
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        fakeDmaReset();
+        decoder.durationBuffer = pass ? durations : NULL;
+        IR_Decoder_Init(&decoder);
+
+        for (uint16_t i = 0; i < BENCH_FRAMES; i++)
+        {
+            uint64_t start;
+
+            fakeDmaFrame((uint8_t)i);
+            start = now();
+            IR_Decoder_Decode(&decoder);
+            ns[pass] += now() - start;
+        }
+        decoded[pass] = frames;
+    }
+
+    printf("duration ring: frames %u vs %u, ring bytes per frame %u vs %u, decode %.1fns vs %.1fns per frame\n",
+           decoded[0], decoded[1], (unsigned)(IR_ENCODER_FRAME_EDGES * sizeof(*data)),
+           (unsigned)(IR_ENCODER_FRAME_EDGES * sizeof(*durations)),
+           (double)ns[0] / BENCH_FRAMES, (double)ns[1] / BENCH_FRAMES);
+}
+
+// the same frames from one ring of both edges and from a falling and a rising ring
+static void benchDualRing(void)
+{
+    uint64_t ns[2] = {0, 0};
+    uint32_t decoded[2];
+
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        fakeDmaReset();
+        if (pass)
+        {
+            writeEdge = &fakeDualWrite;
+            decoder.risingBuffer = risingData;
+            decoder.risingRemaining = &fakeRisingRemaining;
+            IR_Decoder_Init(&decoder);
+        }
+
+        for (uint16_t i = 0; i < BENCH_FRAMES; i++)
+        {
+            uint64_t start;
+
+            fakeDmaFrame((uint8_t)i);
+            start = now();
+            IR_Decoder_Decode(&decoder);
+            ns[pass] += now() - start;
+        }
+        decoded[pass] = frames;
+    }
+
+    printf("dual ring: frames %u vs %u, decode %.1fns per frame from one ring vs %.1fns from two\n",
+           decoded[0], decoded[1], (double)ns[0] / BENCH_FRAMES, (double)ns[1] / BENCH_FRAMES);
+}
+
+// a frame sampled at 50kHz, against how fast a sampler fills the buffer
+static void benchSamples(void)
+{
+    static uint32_t samples[SAMPLE_WORDS];
+    uint64_t times[IR_ENCODER_FRAME_EDGES];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x2C, times);
+    uint16_t words = IR_Generator_Samples(CLOCK_SPEED_MHZ, times, count, SAMPLE_NS, samples);
+    uint64_t start;
+    double seconds;
+
+    fakeDmaReset();
+    start = now();
+    for (uint16_t i = 0; i < BENCH_FRAMES; i++)
+    {
+        IR_Decoder_DecodeSamples(&decoder, samples, words, SAMPLE_NS);
+    }
+    seconds = (now() - start) / 1e9;
+
+    printf("samples: frames %u, %.1fns per 32 samples, %.0f Msamples/s, %.0fx headroom at 50kHz\n",
+           frames, seconds * 1e9 / ((double)BENCH_FRAMES * words),
+           (double)BENCH_FRAMES * words * 32 / seconds / 1e6,
+           (double)BENCH_FRAMES * words * 32 / seconds / (1e9 / SAMPLE_NS));
+}
+
+// every carrier cycle captured and merged into marks, against the demodulated edges
+static void benchCarrier(void)
+{
+    static uint64_t carrier[CARRIER_EDGES];
+    uint64_t times[IR_ENCODER_FRAME_EDGES];
+    uint16_t count = IR_Generator_Timestamps(CLOCK_SPEED_MHZ, 1000, 0x00, 0x3C, times);
+    uint16_t edges = IR_Generator_Carrier(CLOCK_SPEED_MHZ, times, count, carrier);
+    uint64_t ns[2] = {0, 0};
+    uint32_t decoded[2];
+
+    // the edge after the frame closes its last burst
+    carrier[edges] = carrier[edges - 1] + 40000 * CLOCK_SPEED_MHZ;
+    edges++;
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        uint64_t start;
+
+        fakeDmaReset();
+        decoder.carrierGap = pass ? 0 : 100;
+        IR_Decoder_Init(&decoder);
+        start = now();
+        for (uint16_t i = 0; i < BENCH_FRAMES; i++)
+        {
+            // each frame restarts from an idle gap
+            decoder.hasLastEdge = 0;
+            if (pass)
+            {
+                IR_Decoder_DecodeTimestamps(&decoder, times, count);
+            }
+            else
+            {
+                IR_Decoder_DecodeTimestamps(&decoder, carrier, edges);
+            }
+        }
+        ns[pass] = now() - start;
+        decoded[pass] = frames;
+    }
+
+    printf("carrier: frames %u vs %u, %u edges per frame, %.1fns per edge, %.1fus per frame vs %.1fus demodulated\n",
+           decoded[0], decoded[1], edges, (double)ns[0] / ((double)BENCH_FRAMES * edges),
+           ns[0] / 1e3 / BENCH_FRAMES, ns[1] / 1e3 / BENCH_FRAMES);
+}
+
+// three receivers each losing a bit one time in 64, against the first receiver alone
+static void benchCombiner(void)
+{
+    IR_Combiner_t combiner;
+    uint32_t seed = 0xC0FFEE;
+    uint32_t single = 0;
+    uint32_t clean = 0;
+    uint32_t firstCopy = 0;
+
+    combinerTime = 1000;
+    IR_Combiner_Init(&combiner, COMBINER_WINDOW, &combinerClock, &combined_callback);
+    for (uint32_t frame = 0; frame < COMBINER_FRAMES; frame++)
+    {
+        combinedCount = 0;
+        for (uint8_t receiver = 0; receiver < 3; receiver++)
+        {
+            IR_Message_t copy;
+            uint32_t errors = 0;
+            uint32_t bits;
+            uint8_t before = combinedCount;
+
+            for (uint8_t bit = 0; bit < 32; bit++)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                errors |= (uint32_t)((seed & 63) == 0) << bit;
+            }
+
+            // the bits flagged as errors came out wrong
+            bits = (0x10 | 0xEF << 8 | (frame & 0xFF) << 16 | (~frame & 0xFF) << 24) ^ errors;
+            memset(&copy, 0, sizeof(copy));
+            copy.address = bits;
+            copy.addressInv = bits >> 8;
+            copy.command = bits >> 16;
+            copy.commandInv = bits >> 24;
+            copy.addressError = errors;
+            copy.addressInvError = errors >> 8;
+            copy.commandError = errors >> 16;
+            copy.commandInvError = errors >> 24;
+            IR_Combiner_Callback(&combiner, &copy);
+
+            single += !receiver && !errors;
+            firstCopy += !receiver && combinedCount != before;
+            combinerTime += 100;
+        }
+
+        combinerTime += COMBINER_WINDOW;
+        IR_Combiner_Poll(&combiner);
+        clean += combinedClean;
+    }
+
+    printf("combiner: %u of %u clean from one receiver, %u from three, %u out on the first copy\n",
+           single, COMBINER_FRAMES, clean, firstCopy);
+}
+
+static void fakeDmaReset(void)
+{
+    frames = 0;
+    writeEdge = &fakeDmaWrite;
+    encoder.period = PERIOD;
+    encoder.clockSpeed = 1;
+    IR_Encoder_Init(&encoder, 0);
+    dma.decoder = &decoder;
+    dma.data = data;
+    dma.durations = durations;
+    dma.risingData = risingData;
+    dma.size = BUFFER_SIZE;
+    dma.period = PERIOD;
+    dma.clockSpeed = CLOCK_SPEED_MHZ;
+    IR_Generator_DmaInit(&dma, 1000);
+    IR_Decoder_ConfigDefaults(&decoder);
+    decoder.buffer = data;
+    decoder.bufferSize = BUFFER_SIZE;
+    decoder.clockSpeed = CLOCK_SPEED_MHZ;
+    decoder.period = PERIOD;
+    decoder.message = &message;
+    decoder.decodeCallback = &decodeFinished_callback;
+    decoder.captureRemaining = &fakeDmaRemaining;
+    IR_Decoder_Init(&decoder);
+}
+
+static void fakeDmaWrite(uint32_t us)
+{
+    IR_Generator_DmaWrite(&dma, us);
+}
+
+static void fakeDmaFrame(uint8_t command)
+{
+    uint32_t edges[IR_ENCODER_FRAME_EDGES];
+    uint8_t count = IR_Encoder_Frame(&encoder, 0x00, command, edges);
+
+    // idle gap then the encoded frame, written as the time since the previous edge
+    IR_Generator_Widths(edges, count, encoder.period, FRAME_GAP, writeEdge);
+}
+
+static uint32_t fakeDmaRemaining(void)
+{
+    return IR_Generator_DmaRemaining(&dma);
+}
+
+static uint32_t fakeRisingRemaining(void)
+{
+    return IR_Generator_DmaRisingRemaining(&dma);
+}
+
+static void fakeDualWrite(uint32_t us)
+{
+    IR_Generator_DmaDualWrite(&dma, us);
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    frames += !pMessage->repeat;
+}
+
+static void combined_callback(IR_Message_t *pMessage)
+{
+    // only the first message of each frame counts
+    if (!combinedCount++)
+    {
+        combinedClean = !(pMessage->addressError | pMessage->addressInvError | pMessage->commandError |
+                          pMessage->commandInvError);
+    }
+}
+
+static uint32_t combinerClock(void)
+{
+    return combinerTime;
+}
+
+static uint64_t now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + time.tv_nsec;
+}
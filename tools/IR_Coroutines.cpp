@@ -0,0 +1,138 @@
+// example of one thread serving many decoders through IR::Decoder, each with a coroutine awaiting
+// its frames, and a benchmark of the frames/s against plain context callbacks
+#include "IR_Decoder.hpp"
+
+extern "C"
+{
+#include "IR_Encoder.h"
+#include "IR_Timing.h"
+}
+
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <vector>
+
+// eager coroutine destroyed with its owner
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Task(Task &&other) : handle(other.handle) { other.handle = nullptr; }
+    ~Task()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+static uint64_t frames;
+static uint64_t errors;
+
+static Task consume(IR::Decoder &decoder)
+{
+    // a real consumer would act on the key here, possibly awaiting other I/O in between
+    for (uint8_t expected = 0;; expected++)
+    {
+        IR_Message_t message = co_await decoder.next_frame();
+
+        frames++;
+        errors += message.command != expected;
+    }
+}
+
+static void frameCallback(void *context, IR_Message_t *message)
+{
+    uint8_t *expected = static_cast<uint8_t *>(context);
+
+    frames++;
+    errors += message->command != (*expected)++;
+}
+
+// an encoded frame on a decoder's us clock
+static void frameEdges(uint64_t start, uint8_t command, uint64_t *edges)
+{
+    IR_Encoder_t encoder;
+    uint32_t times[IR_ENCODER_FRAME_EDGES];
+    uint8_t count;
+
+    encoder.period = FRAME_PERIOD;
+    encoder.clockSpeed = 1;
+    IR_Encoder_Init(&encoder, 0);
+    count = IR_Encoder_Frame(&encoder, 0x00, command, times);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        edges[i] = start + times[i];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t decoderCount = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000;
+    uint32_t frameCount = argc > 2 ? strtoul(argv[2], NULL, 0) : 20;
+    std::vector<std::unique_ptr<IR::Decoder>> decoders;
+    std::vector<Task> tasks;
+    std::vector<uint8_t> expected(decoderCount);
+    uint64_t edges[IR_ENCODER_FRAME_EDGES];
+
+    // timestamps in us, no capture ring
+    for (uint32_t i = 0; i < decoderCount; i++)
+    {
+        decoders.push_back(std::make_unique<IR::Decoder>(0, 1, 0));
+        tasks.push_back(consume(*decoders.back()));
+    }
+
+    for (uint8_t pass = 0; pass < 2; pass++)
+    {
+        std::chrono::steady_clock::time_point start;
+        double seconds;
+
+        // the second pass swaps the coroutines for plain callbacks on the same decoders
+        if (pass)
+        {
+            for (uint32_t i = 0; i < decoderCount; i++)
+            {
+                decoders[i]->get()->contextCallback = &frameCallback;
+                decoders[i]->get()->callbackContext = &expected[i];
+            }
+        }
+
+        frames = 0;
+        errors = 0;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frameCount; frame++)
+        {
+            frameEdges(1000000 + ((uint64_t)pass * frameCount + frame) * FRAME_PERIOD, frame, edges);
+
+            // every decoder gets its frame in two batches, interleaved as from an event loop
+            for (uint16_t half = 0; half < IR_ENCODER_FRAME_EDGES; half += IR_ENCODER_FRAME_EDGES / 2)
+            {
+                for (uint32_t i = 0; i < decoderCount; i++)
+                {
+                    decoders[i]->decode_timestamps(&edges[half], IR_ENCODER_FRAME_EDGES / 2);
+                }
+            }
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printf("%s: %u decoders, %llu frames, %llu errors, %.0f frames/s\n", pass ? "callback" : "coroutine",
+               decoderCount, (unsigned long long)frames, (unsigned long long)errors, frames / seconds);
+    }
+
+    return errors != 0;
+}
@@ -0,0 +1,292 @@
+// latency histograms from a frame's first edge to its callback, built with IR_DECODER_TRACE, from
+// records "firstEdge lastEdge decodeTime callbackTime" in capture ticks counting past the timer period,
+// one frame a line as logged by a target's callback with captureNow and traceTime set, or from a simulated
+// DMA ring polled at a fixed interval that also decodes on its half and full transfer interrupts like the
+// STM32 example; a latency of a period or more is out of range, the ring captures only place an edge
+// within a period of the decode
+#include "IR_Decoder.h"
+#include "IR_Encoder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BUFFER_SIZE  255
+#define MAX_RECORDS      100000
+#define BUCKETS          24
+#define SIM_CLOCK_MHZ    84
+#define SIM_PERIOD       8400000
+#define SIM_FRAME_PERIOD 108000
+
+typedef struct {
+    uint64_t firstEdge;
+    uint64_t lastEdge;
+    uint64_t decodeTime;
+    uint64_t callbackTime;
+} Record_t;
+
+static Record_t records[MAX_RECORDS];
+static uint32_t recordCount;
+static uint32_t data[MAX_BUFFER_SIZE];
+static uint8_t bufferSize;
+static uint8_t dmaIndex;
+static uint64_t simTime;
+static IR_Decoder_t decoder;
+static IR_Message_t message;
+
+static uint32_t readRecords(FILE *file);
+static uint32_t simulate(uint32_t pollUs, uint32_t frames);
+static void simulateWrite(uint64_t time);
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint32_t simRemaining(void);
+static uint64_t simTraceTime(void);
+static void printStage(const char *name, uint8_t from, uint8_t to, uint8_t clockSpeed, uint32_t period);
+static uint64_t recordTime(const Record_t *record, uint8_t field);
+static int compareTime(const void *a, const void *b);
+
+int main(int argc, char **argv)
+{
+    uint8_t clockSpeed = SIM_CLOCK_MHZ;
+    uint32_t period = SIM_PERIOD;
+    uint32_t expected = 0;
+
+    if (argc >= 4 && !strcmp(argv[1], "-s"))
+    {
+        uint32_t pollUs = strtoul(argv[2], NULL, 0);
+        uint32_t frames = argc > 4 ? strtoul(argv[4], NULL, 0) : 1000;
+
+        bufferSize = strtoul(argv[3], NULL, 0);
+        if (!pollUs || bufferSize < 4 || strtoul(argv[3], NULL, 0) > MAX_BUFFER_SIZE || frames > MAX_RECORDS)
+        {
+            fprintf(stderr, "%s: poll interval must be nonzero, ring size 4 to %d, at most %d frames\n", argv[0],
+                    MAX_BUFFER_SIZE, MAX_RECORDS);
+            return 2;
+        }
+
+        expected = frames;
+        printf("simulated %uus polling, %u edge ring, %u frames\n", pollUs, bufferSize, frames);
+        simulate(pollUs, frames);
+    }
+    else if (argc >= 3)
+    {
+        FILE *file = argc > 3 ? fopen(argv[3], "r") : stdin;
+
+        // period 0 for no range limit
+        clockSpeed = strtoul(argv[1], NULL, 0);
+        period = strtoul(argv[2], NULL, 0);
+        if (!file)
+        {
+            perror(argv[3]);
+            return 1;
+        }
+        if (!clockSpeed)
+        {
+            fprintf(stderr, "%s: clock must be nonzero\n", argv[0]);
+            return 2;
+        }
+        readRecords(file);
+    }
+    else
+    {
+        fprintf(stderr, "usage: %s clockMHz period [records]\n       %s -s pollUs ringSize [frames]\n", argv[0],
+                argv[0]);
+        return 2;
+    }
+
+    printf("%u frames", recordCount);
+    if (expected)
+    {
+        printf(", %u lost", expected - recordCount);
+    }
+    printf("\n");
+
+    printStage("first edge to callback", 0, 3, clockSpeed, period);
+    printStage("last edge to decode call", 1, 2, clockSpeed, period);
+    printStage("decode call to callback", 2, 3, clockSpeed, period);
+
+    return 0;
+}
+
+static uint32_t readRecords(FILE *file)
+{
+    unsigned long long first;
+    unsigned long long last;
+    unsigned long long decode;
+    unsigned long long callback;
+
+    while (recordCount < MAX_RECORDS && fscanf(file, "%llu %llu %llu %llu", &first, &last, &decode, &callback) == 4)
+    {
+        records[recordCount].firstEdge = first;
+        records[recordCount].lastEdge = last;
+        records[recordCount].decodeTime = decode;
+        records[recordCount].callbackTime = callback;
+        recordCount++;
+    }
+
+    return recordCount;
+}
+
+static uint32_t simulate(uint32_t pollUs, uint32_t frames)
+{
+    uint64_t pollTicks = (uint64_t)pollUs * SIM_CLOCK_MHZ;
+    uint64_t nextPoll = pollTicks;
+    IR_Encoder_t encoder;
+
+    IR_Decoder_ConfigDefaults(&decoder);
+    decoder.buffer = data;
+    decoder.bufferSize = bufferSize;
+    decoder.clockSpeed = SIM_CLOCK_MHZ;
+    decoder.period = SIM_PERIOD;
+    decoder.message = &message;
+    decoder.decodeCallback = &decodeFinished_callback;
+    decoder.captureRemaining = &simRemaining;
+    decoder.captureNow = &simTraceTime;
+    decoder.traceTime = &simTraceTime;
+    IR_Decoder_Init(&decoder);
+    encoder.period = SIM_PERIOD;
+    encoder.clockSpeed = SIM_CLOCK_MHZ;
+
+    // frames start at unrelated phases of the poll, the decode calls themselves take no time
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        uint64_t time = (1000 + (uint64_t)frame * SIM_FRAME_PERIOD + frame * 7919 % 1000) * SIM_CLOCK_MHZ;
+        uint32_t edges[IR_ENCODER_FRAME_EDGES];
+        uint8_t count;
+
+        // encoded from 0, a frame is far shorter than the timer period
+        IR_Encoder_Init(&encoder, 0);
+        count = IR_Encoder_Frame(&encoder, 0x00, (uint8_t)frame, edges);
+        for (uint8_t i = 0; i < count; i++)
+        {
+            while (nextPoll < time + edges[i])
+            {
+                simTime = nextPoll;
+                IR_Decoder_Decode(&decoder);
+                nextPoll += pollTicks;
+            }
+            simulateWrite(time + edges[i]);
+        }
+    }
+
+    // let the last frame out
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        simTime = nextPoll;
+        IR_Decoder_Decode(&decoder);
+        nextPoll += pollTicks;
+    }
+
+    return recordCount;
+}
+
+static void simulateWrite(uint64_t time)
+{
+    data[dmaIndex] = time % SIM_PERIOD;
+    dmaIndex = (dmaIndex + 1) % bufferSize;
+    simTime = time;
+
+    if (!dmaIndex)
+    {
+        IR_Decoder_CaptureWrapped(&decoder);
+    }
+    if (dmaIndex == bufferSize / 2 || !dmaIndex)
+    {
+        IR_Decoder_Decode(&decoder);
+    }
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    if (pMessage->repeat || recordCount == MAX_RECORDS)
+    {
+        return;
+    }
+
+    records[recordCount].firstEdge = pMessage->firstEdge;
+    records[recordCount].lastEdge = pMessage->lastEdge;
+    records[recordCount].decodeTime = pMessage->decodeTime;
+    records[recordCount].callbackTime = pMessage->callbackTime;
+    recordCount++;
+}
+
+static uint32_t simRemaining(void)
+{
+    return bufferSize - dmaIndex;
+}
+
+static uint64_t simTraceTime(void)
+{
+    // the capture timer counter extended by its overflows
+    return simTime;
+}
+
+static void printStage(const char *name, uint8_t from, uint8_t to, uint8_t clockSpeed, uint32_t period)
+{
+    static uint64_t latencies[MAX_RECORDS];
+    uint32_t buckets[BUCKETS] = { 0 };
+    uint32_t most = 1;
+    uint32_t count = 0;
+
+    // not folded back into the period, a time running backwards is out of range as well
+    for (uint32_t i = 0; i < recordCount; i++)
+    {
+        uint64_t ticks = recordTime(&records[i], to) - recordTime(&records[i], from);
+        uint8_t bucket = 0;
+
+        if (period && ticks >= period)
+        {
+            continue;
+        }
+        latencies[count] = ticks / clockSpeed;
+
+        while (bucket < BUCKETS - 1 && latencies[count] >> bucket)
+        {
+            bucket++;
+        }
+        buckets[bucket]++;
+        most = buckets[bucket] > most ? buckets[bucket] : most;
+        count++;
+    }
+
+    printf("\n%s:", name);
+    if (count < recordCount)
+    {
+        printf(" %u out of range,", recordCount - count);
+    }
+    if (!count)
+    {
+        printf(" none in range\n");
+        return;
+    }
+    qsort(latencies, count, sizeof(uint64_t), &compareTime);
+
+    printf(" p50 %lluus p99 %lluus max %lluus\n", (unsigned long long)latencies[count / 2],
+           (unsigned long long)latencies[count * 99 / 100], (unsigned long long)latencies[count - 1]);
+    for (uint8_t bucket = 0; bucket < BUCKETS; bucket++)
+    {
+        if (buckets[bucket])
+        {
+            char bar[41];
+            uint8_t width = (uint64_t)buckets[bucket] * 40 / most;
+
+            memset(bar, '#', width);
+            bar[width] = 0;
+            printf("  < %8luus %6u %s\n", 1UL << bucket, buckets[bucket], bar);
+        }
+    }
+}
+
+static uint64_t recordTime(const Record_t *record, uint8_t field)
+{
+    const uint64_t times[] = { record->firstEdge, record->lastEdge, record->decodeTime, record->callbackTime };
+
+    return times[field];
+}
+
+static int compareTime(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+
+    return (left > right) - (left < right);
+}
@@ -0,0 +1,212 @@
+// load generator for IR_Service, sends frames for many streams and measures decoded frame
+// throughput and the latency from sending a frame's last batch to receiving the frame
+#define _GNU_SOURCE
+#include "IR_Encoder.h"
+#include "IR_Service.h"
+#include "IR_Timing.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_STREAMS 10000
+#define DEFAULT_FRAMES  10
+
+static int clientSocket;
+static uint32_t streamCount;
+static uint32_t frameCount;
+static uint64_t expected;
+static uint64_t *latencies;
+static uint64_t receivedFrames;
+static uint64_t outOfOrder;
+static uint64_t errors;
+static uint64_t lastReceive;
+static uint8_t *nextCommand;
+
+static void *receive_thread(void *arg);
+static uint16_t frameEdges(uint64_t start, uint8_t address, uint8_t command, uint64_t *edges);
+static int compareLatency(const void *a, const void *b);
+static uint64_t now(void);
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_un service;
+    struct sockaddr_un address;
+    struct timeval timeout = { 1, 0 };
+    int bufferSize = 8 << 20;
+    uint64_t rate;
+    uint64_t start;
+    uint64_t *streamTime;
+    pthread_t receiver;
+
+    if (argc < 2 || strlen(argv[1]) >= sizeof(service.sun_path))
+    {
+        fprintf(stderr, "usage: %s socket [streams] [frames per stream] [frames per second, 0 unpaced]\n", argv[0]);
+        return 2;
+    }
+    streamCount = argc > 2 ? strtoul(argv[2], NULL, 0) : DEFAULT_STREAMS;
+    frameCount = argc > 3 ? strtoul(argv[3], NULL, 0) : DEFAULT_FRAMES;
+    rate = argc > 4 ? strtoull(argv[4], NULL, 0) : 0;
+    expected = (uint64_t)streamCount * frameCount;
+
+    latencies = malloc(expected * sizeof(uint64_t));
+    nextCommand = calloc(streamCount, 1);
+    streamTime = calloc(streamCount, sizeof(uint64_t));
+    if (!latencies || !nextCommand || !streamTime)
+    {
+        perror(argv[0]);
+        return 1;
+    }
+
+    memset(&service, 0, sizeof(service));
+    service.sun_family = AF_UNIX;
+    strcpy(service.sun_path, argv[1]);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "/tmp/IR_LoadGen.%d", (int)getpid());
+    unlink(address.sun_path);
+
+    clientSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (clientSocket < 0 || bind(clientSocket, (struct sockaddr *)&address, sizeof(address)))
+    {
+        perror(address.sun_path);
+        return 1;
+    }
+    setsockopt(clientSocket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    for (uint32_t i = 0; i < streamCount; i++)
+    {
+        // streams start at unrelated times
+        streamTime[i] = 1000000 + (uint64_t)i * 7919 % FRAME_PERIOD;
+    }
+
+    pthread_create(&receiver, NULL, &receive_thread, NULL);
+    start = now();
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        for (uint32_t i = 0; i < streamCount; i++)
+        {
+            uint64_t edges[IR_ENCODER_FRAME_EDGES];
+            uint16_t count = frameEdges(streamTime[i], i & 0xFF, frame & 0xFF, edges);
+            IR_ServiceBatch_t batch;
+
+            if (rate)
+            {
+                uint64_t due = start + ((uint64_t)frame * streamCount + i) * 1000000000ULL / rate;
+                int64_t wait = due - now();
+
+                if (wait > 0)
+                {
+                    struct timespec delay = { wait / 1000000000, wait % 1000000000 };
+
+                    nanosleep(&delay, NULL);
+                }
+            }
+
+            // each frame goes out in two batches like a receiver flushing at its half transfer
+            batch.stream = i;
+            batch.reserved = 0;
+            for (uint16_t sent = 0; sent < count; sent += batch.count)
+            {
+                batch.count = count - sent > count / 2 ? count / 2 : count - sent;
+                memcpy(batch.edges, &edges[sent], batch.count * sizeof(uint64_t));
+                batch.sendTime = now();
+                if (sendto(clientSocket, &batch, IR_SERVICE_BATCH_SIZE(batch.count), 0, (struct sockaddr *)&service,
+                           sizeof(service)) < 0)
+                {
+                    perror(argv[1]);
+                    return 1;
+                }
+            }
+            streamTime[i] += FRAME_PERIOD;
+        }
+    }
+    pthread_join(receiver, NULL);
+
+    qsort(latencies, receivedFrames, sizeof(uint64_t), &compareLatency);
+    printf("%u streams x %u frames: %llu received, %llu out of order, %llu with errors\n", streamCount, frameCount,
+           (unsigned long long)receivedFrames, (unsigned long long)outOfOrder, (unsigned long long)errors);
+    if (receivedFrames)
+    {
+        double seconds = (lastReceive - start) / 1e9;
+
+        printf("%.0f frames/s, %.0f edges/s, latency p50 %.1fus p99 %.1fus max %.1fus\n", receivedFrames / seconds,
+               receivedFrames * IR_ENCODER_FRAME_EDGES / seconds, latencies[receivedFrames / 2] / 1e3,
+               latencies[receivedFrames * 99 / 100] / 1e3, latencies[receivedFrames - 1] / 1e3);
+    }
+
+    close(clientSocket);
+    unlink(address.sun_path);
+    return receivedFrames == expected && !outOfOrder && !errors ? 0 : 1;
+}
+
+static void *receive_thread(void *arg)
+{
+    IR_ServiceFrame_t frame;
+
+    (void)arg;
+    while (receivedFrames < expected)
+    {
+        // gives up after a second without frames
+        if (recv(clientSocket, &frame, sizeof(frame), 0) != sizeof(frame))
+        {
+            break;
+        }
+
+        lastReceive = now();
+        if (frame.stream >= streamCount)
+        {
+            errors++;
+            continue;
+        }
+
+        latencies[receivedFrames++] = lastReceive - frame.sendTime;
+        if (frame.command != nextCommand[frame.stream] || frame.address != (frame.stream & 0xFF))
+        {
+            outOfOrder++;
+        }
+        nextCommand[frame.stream] = frame.command + 1;
+        errors += frame.errors != 0;
+    }
+
+    return NULL;
+}
+
+// an encoded frame on the stream's us clock
+static uint16_t frameEdges(uint64_t start, uint8_t address, uint8_t command, uint64_t *edges)
+{
+    IR_Encoder_t encoder = { .period = FRAME_PERIOD, .clockSpeed = 1 };
+    uint32_t times[IR_ENCODER_FRAME_EDGES];
+    uint8_t count;
+
+    IR_Encoder_Init(&encoder, 0);
+    count = IR_Encoder_Frame(&encoder, address, command, times);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        edges[i] = start + times[i];
+    }
+
+    return count;
+}
+
+static int compareLatency(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+
+    return (left > right) - (left < right);
+}
+
+static uint64_t now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + time.tv_nsec;
+}
@@ -0,0 +1,112 @@
+// decode cost on noise alone, a site with no remote in use where the decoder does nothing but hunt for a lead-in;
+// only calls that predate the edge by edge lead-in seek are used so make noise can build it on an older tree too
+#include "IR_Decoder.h"
+#include "IR_Generator.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BUFFER_SIZE     136
+#define CLOCK_SPEED_MHZ 84
+#define PERIOD          8400000
+#define DECODE_CHUNK    32 // edges written between decode calls
+#define ROUNDS          5
+
+static uint32_t data[BUFFER_SIZE];
+static uint32_t dmaIndex;
+static uint32_t frames;
+
+static uint32_t fakeDmaRemaining(void);
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint64_t now(void);
+static double noiseRound(void);
+
+int main(void)
+{
+    double best = 0;
+
+    for (uint8_t round = 0; round < ROUNDS; round++)
+    {
+        double ns = noiseRound();
+
+        if (!round || ns < best)
+        {
+            best = ns;
+        }
+    }
+
+    printf("noise: best of %u, decode %.1fns per edge, frames %u\n", ROUNDS, best, frames);
+    return 0;
+}
+
+static double noiseRound(void)
+{
+    IR_Decoder_t decoder;
+    IR_Message_t message;
+    IR_Generator_t generator;
+    uint32_t edges[IR_GENERATOR_MAX_EDGES];
+    uint32_t count = 0;
+    uint64_t ns = 0;
+
+    memset(data, 0, sizeof(data));
+    dmaIndex = 0;
+    memset(&decoder, 0, sizeof(decoder));
+    decoder.buffer = data;
+    decoder.bufferSize = BUFFER_SIZE;
+    decoder.clockSpeed = CLOCK_SPEED_MHZ;
+    decoder.period = PERIOD;
+    decoder.message = &message;
+    decoder.decodeCallback = &decodeFinished_callback;
+    decoder.captureRemaining = &fakeDmaRemaining;
+    IR_Decoder_Init(&decoder);
+
+    generator.period = PERIOD;
+    generator.clockSpeed = CLOCK_SPEED_MHZ;
+    IR_Generator_Init(&generator, 1000, 0x1234567);
+    for (uint16_t i = 0; i < 1000; i++)
+    {
+        uint16_t noise = IR_Generator_Noise(&generator, IR_GENERATOR_MAX_EDGES, 10000, edges);
+
+        for (uint16_t written = 0; written < noise; written += DECODE_CHUNK)
+        {
+            uint64_t start;
+
+            for (uint16_t e = written; e < noise && e < written + DECODE_CHUNK; e++)
+            {
+                data[dmaIndex] = edges[e];
+                dmaIndex = (dmaIndex + 1) % BUFFER_SIZE;
+                if (!dmaIndex)
+                {
+                    IR_Decoder_CaptureWrapped(&decoder);
+                }
+            }
+
+            start = now();
+            IR_Decoder_Decode(&decoder);
+            ns += now() - start;
+        }
+        count += noise;
+    }
+
+    return (double)ns / count;
+}
+
+static uint32_t fakeDmaRemaining(void)
+{
+    return BUFFER_SIZE - dmaIndex;
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    (void)pMessage;
+    frames++;
+}
+
+static uint64_t now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + time.tv_nsec;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+# builds the coroutine benchmark with and without the ir_decoder static probes, runs both to show the
+# cost of unattached probes, then runs the probed build again under bpftrace with IR_Probes.bt
+# needs sys/sdt.h (systemtap-sdt-dev), bpftrace and root for the last step
+# usage: tools/IR_Probes.sh [decoders] [frames per decoder]
+set -e
+
+decoders=${1:-100}
+frames=${2:-4000}
+root=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+build()
+{
+    (cd "$work" && ${CC:-cc} -O2 -c "$root"/src/*.c -I"$root/include" $2 &&
+     ${CXX:-c++} -O2 -std=c++20 -I"$root/include" "$root/tools/IR_Coroutines.cpp" ./*.o -o "$1" && rm -f ./*.o)
+}
+
+build "$work/plain" ""
+build "$work/probes" "-DIR_DECODER_PROBES"
+
+echo "probes in the binary:"
+readelf -n "$work/probes" | grep -c "NT_STAPSDT" || true
+
+for run in 1 2 3
+do
+    echo "run $run without probes:"
+    "$work/plain" "$decoders" "$frames"
+    echo "run $run with probes, unattached:"
+    "$work/probes" "$decoders" "$frames"
+done
+
+if command -v bpftrace > /dev/null
+then
+    echo "with probes, attached:"
+    bpftrace "$root/tools/IR_Probes.bt" -c "$work/probes $decoders $frames"
+else
+    echo "bpftrace not found, skipping the attached run"
+fi
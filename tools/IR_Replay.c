@@ -0,0 +1,105 @@
+// replays a trace written by IR_Recorder with the recorded call boundaries,
+// printing every decoded frame and the time spent in each IR_Decoder_Decode call
+#include "IR_Decoder.h"
+#include "IR_Recorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_BUFFER_SIZE 255
+
+static uint32_t data[MAX_BUFFER_SIZE];
+static uint32_t callNumber;
+static uint8_t quiet;
+
+static void decodeFinished_callback(IR_Message_t *pMessage);
+static uint64_t now(void);
+
+int main(int argc, char **argv)
+{
+    IR_Decoder_t decoder;
+    IR_Message_t message;
+    IR_Replay_t replay;
+    uint8_t *trace;
+    FILE *file;
+    long length;
+    uint32_t callTime;
+    uint64_t total = 0;
+    uint64_t slowest = 0;
+
+    if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "-q")))
+    {
+        fprintf(stderr, "usage: %s trace [-q]\n", argv[0]);
+        return 2;
+    }
+    quiet = argc == 3;
+
+    file = fopen(argv[1], "rb");
+    if (!file || fseek(file, 0, SEEK_END) || (length = ftell(file)) < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    rewind(file);
+    trace = malloc(length);
+    if (!trace || fread(trace, 1, length, file) != (size_t)length)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    fclose(file);
+
+    decoder.buffer = data;
+    decoder.message = &message;
+    decoder.decodeCallback = &decodeFinished_callback;
+    if (!IR_Replay_Init(&replay, trace, length, &decoder))
+    {
+        fprintf(stderr, "%s: not a version %d trace\n", argv[1], IR_RECORDER_VERSION);
+        return 1;
+    }
+
+    while (IR_Replay_Next(&replay, &callTime))
+    {
+        uint64_t start;
+        uint64_t elapsed;
+
+        if (!quiet)
+        {
+            printf("call %u at %u\n", callNumber, callTime);
+        }
+
+        start = now();
+        IR_Decoder_Decode(&decoder);
+        elapsed = now() - start;
+
+        total += elapsed;
+        slowest = elapsed > slowest ? elapsed : slowest;
+        callNumber++;
+    }
+
+    printf("%u calls, %u overruns, decode mean %.1fns max %lluns\n", callNumber, decoder.overruns,
+           callNumber ? (double)total / callNumber : 0.0, (unsigned long long)slowest);
+
+    free(trace);
+    return 0;
+}
+
+static void decodeFinished_callback(IR_Message_t *pMessage)
+{
+    if (!quiet)
+    {
+        printf("  address:%d command:%d repeat:%d errors:%02x%02x%02x%02x\n", pMessage->address, pMessage->command,
+               pMessage->repeat, pMessage->addressError, pMessage->addressInvError, pMessage->commandError,
+               pMessage->commandInvError);
+    }
+}
+
+static uint64_t now(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000u + time.tv_nsec;
+}
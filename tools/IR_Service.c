@@ -0,0 +1,362 @@
+// host service decoding many independent edge streams received over a UNIX datagram socket,
+// each stream owns a decoder and streams ready to decode are shared out over a pool of workers
+// that steal from each other when idle, a stream is only ever decoded by one worker at a time so
+// its frames are sent back in order
+#define _GNU_SOURCE
+#include "IR_Decoder.h"
+#include "IR_Service.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define DEFAULT_STREAMS 16384
+#define DEFAULT_WORKERS 4
+#define STREAM_EDGES    256
+#define STREAM_BATCHES  8
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    IR_Decoder_t *decoder; // in the decoder arena, away from the lines the socket reader writes
+    uint64_t edges[STREAM_EDGES]; // received but not yet decoded
+    uint16_t count;
+    uint16_t batchEnd[STREAM_BATCHES]; // edges before this came in the batch sent at batchSendTime
+    uint64_t batchSendTime[STREAM_BATCHES];
+    uint8_t batches;
+    uint8_t scheduled; // queued on a worker or being decoded
+    struct sockaddr_un client;
+    socklen_t clientLength;
+} Stream_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint32_t *ready; // ring of stream ids, a stream is queued at most once so it never fills
+    uint32_t head;
+    uint32_t tail;
+    pthread_t thread;
+    uint64_t batches;
+    uint64_t frames;
+    uint64_t steals;
+} Worker_t;
+
+static Stream_t *streams;
+static uint8_t *decoderArena;
+static uint32_t streamCount;
+static Worker_t *workers;
+static uint32_t workerCount;
+static uint32_t readyCount;
+static pthread_mutex_t idleLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idleCond = PTHREAD_COND_INITIALIZER;
+static volatile sig_atomic_t running = 1;
+static int serviceSocket;
+
+// reply details of the batch being decoded by this worker
+static __thread Worker_t *currentWorker;
+static __thread struct sockaddr_un replyTo;
+static __thread socklen_t replyLength;
+static __thread uint64_t replySendTime;
+
+static void *worker_thread(void *arg);
+static void decodeFinished_callback(void *context, IR_Message_t *pMessage);
+static void schedule(Worker_t *worker, uint32_t id);
+static uint8_t take(Worker_t *worker, uint32_t *id, uint8_t steal);
+static void decodeStream(Stream_t *stream);
+static void stop_handler(int signal);
+
+int main(int argc, char **argv)
+{
+    struct sockaddr_un address;
+    struct timeval timeout = { 0, 100000 };
+    int bufferSize = 8 << 20;
+    IR_ServiceBatch_t batch;
+    uint64_t received = 0;
+    uint64_t dropped = 0;
+    uint64_t batches = 0;
+    uint64_t frames = 0;
+    uint64_t steals = 0;
+
+    if (argc < 2 || strlen(argv[1]) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "usage: %s socket [streams] [workers]\n", argv[0]);
+        return 2;
+    }
+    streamCount = argc > 2 ? strtoul(argv[2], NULL, 0) : DEFAULT_STREAMS;
+    workerCount = argc > 3 ? strtoul(argv[3], NULL, 0) : DEFAULT_WORKERS;
+    if (!streamCount || !workerCount)
+    {
+        fprintf(stderr, "%s: streams and workers must be nonzero\n", argv[0]);
+        return 2;
+    }
+
+    streams = calloc(streamCount, sizeof(*streams));
+    workers = calloc(workerCount, sizeof(*workers));
+    decoderArena = malloc((size_t)streamCount * IR_Decoder_Size(0));
+    if (!streams || !workers || !decoderArena)
+    {
+        perror(argv[0]);
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < streamCount; i++)
+    {
+        // timestamps in us and no capture ring
+        pthread_mutex_init(&streams[i].lock, NULL);
+        streams[i].decoder = IR_Decoder_Create(&decoderArena[(size_t)i * IR_Decoder_Size(0)], IR_Decoder_Size(0), 0, 1,
+                                               0, NULL);
+        streams[i].decoder->contextCallback = &decodeFinished_callback;
+        streams[i].decoder->callbackContext = &streams[i];
+    }
+
+    serviceSocket = socket(AF_UNIX, SOCK_DGRAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, argv[1]);
+    unlink(argv[1]);
+    if (serviceSocket < 0 || bind(serviceSocket, (struct sockaddr *)&address, sizeof(address)))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    setsockopt(serviceSocket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    setsockopt(serviceSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    signal(SIGINT, &stop_handler);
+    signal(SIGTERM, &stop_handler);
+
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        pthread_mutex_init(&workers[i].lock, NULL);
+        workers[i].ready = malloc((streamCount + 1) * sizeof(uint32_t));
+        if (!workers[i].ready || pthread_create(&workers[i].thread, NULL, &worker_thread, &workers[i]))
+        {
+            perror(argv[0]);
+            return 1;
+        }
+    }
+
+    while (running)
+    {
+        struct sockaddr_un client;
+        socklen_t clientLength = sizeof(client);
+        ssize_t length = recvfrom(serviceSocket, &batch, sizeof(batch), 0, (struct sockaddr *)&client, &clientLength);
+        Stream_t *stream;
+
+        if (length < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                perror("recvfrom");
+            }
+            continue;
+        }
+
+        if ((size_t)length < IR_SERVICE_BATCH_SIZE(0) || batch.count > IR_SERVICE_MAX_EDGES ||
+            (size_t)length != IR_SERVICE_BATCH_SIZE(batch.count) || batch.stream >= streamCount)
+        {
+            dropped++;
+            continue;
+        }
+
+        stream = &streams[batch.stream];
+        pthread_mutex_lock(&stream->lock);
+        if (stream->count + batch.count > STREAM_EDGES || stream->batches == STREAM_BATCHES)
+        {
+            // the stream fell too far behind, the decoder resyncs on a later lead-in
+            dropped++;
+        }
+        else
+        {
+            memcpy(&stream->edges[stream->count], batch.edges, batch.count * sizeof(uint64_t));
+            stream->count += batch.count;
+            if (batch.count)
+            {
+                stream->batchEnd[stream->batches] = stream->count;
+                stream->batchSendTime[stream->batches++] = batch.sendTime;
+            }
+            stream->client = client;
+            stream->clientLength = clientLength;
+            received++;
+        }
+
+        if (!stream->scheduled && stream->count)
+        {
+            stream->scheduled = 1;
+            schedule(&workers[batch.stream % workerCount], batch.stream);
+        }
+        pthread_mutex_unlock(&stream->lock);
+    }
+
+    pthread_mutex_lock(&idleLock);
+    pthread_cond_broadcast(&idleCond);
+    pthread_mutex_unlock(&idleLock);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        batches += workers[i].batches;
+        frames += workers[i].frames;
+        steals += workers[i].steals;
+    }
+
+    printf("%u streams, %u workers: %llu batches received, %llu dropped, %llu decodes, %llu frames, %llu steals\n",
+           streamCount, workerCount, (unsigned long long)received, (unsigned long long)dropped,
+           (unsigned long long)batches, (unsigned long long)frames, (unsigned long long)steals);
+
+    close(serviceSocket);
+    unlink(argv[1]);
+    free(decoderArena);
+    return 0;
+}
+
+static void *worker_thread(void *arg)
+{
+    Worker_t *worker = arg;
+    uint32_t id;
+
+    currentWorker = worker;
+    for (;;)
+    {
+        uint8_t found = take(worker, &id, 0);
+
+        // own streams first, then steal from the others starting after this worker
+        for (uint32_t i = 1; !found && i < workerCount; i++)
+        {
+            found = take(&workers[(worker - workers + i) % workerCount], &id, 1);
+            worker->steals += found;
+        }
+
+        if (found)
+        {
+            decodeStream(&streams[id]);
+            continue;
+        }
+
+        pthread_mutex_lock(&idleLock);
+        while (!__atomic_load_n(&readyCount, __ATOMIC_ACQUIRE) && running)
+        {
+            pthread_cond_wait(&idleCond, &idleLock);
+        }
+        pthread_mutex_unlock(&idleLock);
+
+        if (!running && !__atomic_load_n(&readyCount, __ATOMIC_ACQUIRE))
+        {
+            return NULL;
+        }
+    }
+}
+
+static void decodeStream(Stream_t *stream)
+{
+    uint64_t edges[STREAM_EDGES];
+    uint16_t batchEnd[STREAM_BATCHES];
+    uint64_t batchSendTime[STREAM_BATCHES];
+    uint8_t batches;
+
+    pthread_mutex_lock(&stream->lock);
+    batches = stream->batches;
+    memcpy(edges, stream->edges, stream->count * sizeof(uint64_t));
+    memcpy(batchEnd, stream->batchEnd, batches * sizeof(uint16_t));
+    memcpy(batchSendTime, stream->batchSendTime, batches * sizeof(uint64_t));
+    stream->count = 0;
+    stream->batches = 0;
+    replyTo = stream->client;
+    replyLength = stream->clientLength;
+    pthread_mutex_unlock(&stream->lock);
+
+    // batch by batch so each frame echoes the send time of the batch that completed it
+    for (uint8_t i = 0; i < batches; i++)
+    {
+        uint16_t from = i ? batchEnd[i - 1] : 0;
+
+        replySendTime = batchSendTime[i];
+        IR_Decoder_DecodeTimestamps(stream->decoder, &edges[from], batchEnd[i] - from);
+        currentWorker->batches++;
+    }
+
+    // edges that arrived meanwhile go to the back of this worker's queue so busy streams take turns
+    pthread_mutex_lock(&stream->lock);
+    if (stream->count)
+    {
+        schedule(currentWorker, stream - streams);
+    }
+    else
+    {
+        stream->scheduled = 0;
+    }
+    pthread_mutex_unlock(&stream->lock);
+}
+
+static void schedule(Worker_t *worker, uint32_t id)
+{
+    pthread_mutex_lock(&worker->lock);
+    worker->ready[worker->tail] = id;
+    worker->tail = (worker->tail + 1) % (streamCount + 1);
+    pthread_mutex_unlock(&worker->lock);
+
+    __atomic_add_fetch(&readyCount, 1, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&idleLock);
+    pthread_cond_signal(&idleCond);
+    pthread_mutex_unlock(&idleLock);
+}
+
+static uint8_t take(Worker_t *worker, uint32_t *id, uint8_t steal)
+{
+    uint8_t found = 0;
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->head != worker->tail)
+    {
+        // the owner takes the oldest stream, a thief the newest
+        if (steal)
+        {
+            worker->tail = (worker->tail + streamCount) % (streamCount + 1);
+            *id = worker->ready[worker->tail];
+        }
+        else
+        {
+            *id = worker->ready[worker->head];
+            worker->head = (worker->head + 1) % (streamCount + 1);
+        }
+        found = 1;
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    if (found)
+    {
+        __atomic_sub_fetch(&readyCount, 1, __ATOMIC_RELEASE);
+    }
+
+    return found;
+}
+
+static void decodeFinished_callback(void *context, IR_Message_t *pMessage)
+{
+    IR_ServiceFrame_t frame;
+
+    frame.stream = (Stream_t *)context - streams;
+    frame.address = pMessage->address;
+    frame.command = pMessage->command;
+    frame.repeat = pMessage->repeat;
+    frame.errors = pMessage->addressError | pMessage->addressInvError | pMessage->commandError |
+                   pMessage->commandInvError;
+    frame.sendTime = replySendTime;
+    currentWorker->frames++;
+
+    if (replyLength > sizeof(sa_family_t))
+    {
+        sendto(serviceSocket, &frame, sizeof(frame), 0, (struct sockaddr *)&replyTo, replyLength);
+    }
+}
+
+static void stop_handler(int signal)
+{
+    (void)signal;
+    running = 0;
+}
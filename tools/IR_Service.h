@@ -0,0 +1,33 @@
+#ifndef IR_SERVICE_H
+#define IR_SERVICE_H
+
+#include <stdint.h>
+
+// wire format of the IR_Service UNIX datagram socket, host byte order
+
+#define IR_SERVICE_MAX_EDGES 64
+
+// a batch of edges from one stream, edges continue the stream's previous batch
+typedef struct
+{
+    uint32_t stream;
+    uint16_t count;
+    uint16_t reserved;
+    uint64_t sendTime; // CLOCK_MONOTONIC ns of the sender, echoed in the frames this batch completes
+    uint64_t edges[IR_SERVICE_MAX_EDGES]; // monotonic edge times in us
+} IR_ServiceBatch_t;
+
+// a decoded frame or repeat sent back to the address the stream's batches came from
+typedef struct
+{
+    uint32_t stream;
+    uint8_t address;
+    uint8_t command;
+    uint8_t repeat;
+    uint8_t errors; // OR of the four bytes' error masks, bits that failed to decode, 0 for a clean frame
+    uint64_t sendTime; // of the batch holding the frame's last edge
+} IR_ServiceFrame_t;
+
+#define IR_SERVICE_BATCH_SIZE(count) (sizeof(IR_ServiceBatch_t) - (IR_SERVICE_MAX_EDGES - (count)) * sizeof(uint64_t))
+
+#endif /* IR_SERVICE_H */